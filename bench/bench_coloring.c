@@ -0,0 +1,148 @@
+#define RK_ARENA_IMPLEMENTATION
+#include "../rkmemory/rkarena.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Models many per-thread/per-request arenas whose first objects are all hot
+// at the same time, e.g. a worker cycling through the state of its requests
+
+#define NUM_ARENAS 512
+#define OBJECT_SIZE 64
+#define OBJECTS_PER_ARENA 4
+#define ROUNDS 2000
+
+typedef struct Counter
+{
+    int fd; // The perf event file descriptor, or -1 if unavailable
+} Counter;
+
+static Counter openL1Misses(void)
+{
+    Counter c = { -1 };
+#if defined(__linux__) && defined(SYS_perf_event_open)
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_L1D
+        | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+        | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    c.fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    return c;
+}
+
+static void startCounter(Counter c)
+{
+#if defined(__linux__)
+    if (c.fd >= 0)
+    {
+        ioctl(c.fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(c.fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#else
+    (void)c;
+#endif
+}
+
+static long long stopCounter(Counter c)
+{
+    long long value = -1;
+#if defined(__linux__)
+    if (c.fd >= 0)
+    {
+        ioctl(c.fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(c.fd, &value, sizeof(value)) != sizeof(value))
+        {
+            value = -1;
+        }
+    }
+#else
+    (void)c;
+#endif
+    return value;
+}
+
+static double nowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void run(const char *name, unsigned flags, Counter counter)
+{
+    static rkArena *arenas[NUM_ARENAS];
+    static volatile uint64_t *objects[NUM_ARENAS * OBJECTS_PER_ARENA];
+
+    for (int i = 0; i < NUM_ARENAS; i++)
+    {
+        arenas[i] = rkCreateArenaWithFlags(8 * 1024, flags);
+        if (!arenas[i])
+        {
+            fprintf(stderr, "Failed to allocate arena\n");
+            exit(EXIT_FAILURE);
+        }
+
+        for (int j = 0; j < OBJECTS_PER_ARENA; j++)
+        {
+            objects[i * OBJECTS_PER_ARENA + j] = (volatile uint64_t *)rkArenaAllocZeroed(arenas[i], OBJECT_SIZE);
+        }
+    }
+
+    uint64_t sum = 0;
+    startCounter(counter);
+    const double start = nowSeconds();
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        for (int i = 0; i < NUM_ARENAS * OBJECTS_PER_ARENA; i++)
+        {
+            sum += ++*objects[i];
+        }
+    }
+    const double elapsed = nowSeconds() - start;
+    const long long misses = stopCounter(counter);
+
+    const double accesses = (double)ROUNDS * NUM_ARENAS * OBJECTS_PER_ARENA;
+    printf("%-12s %8.2f ns/access", name, elapsed * 1e9 / accesses);
+    if (misses >= 0)
+    {
+        printf("  %8.4f L1D misses/access", (double)misses / accesses);
+    }
+    else
+    {
+        printf("  (L1D miss counter unavailable)");
+    }
+    printf("  checksum=%llu\n", (unsigned long long)sum);
+
+    for (int i = 0; i < NUM_ARENAS; i++)
+    {
+        rkFreeArena(arenas[i]);
+    }
+}
+
+int main(void)
+{
+    const Counter counter = openL1Misses();
+
+    printf("%d arenas, %d hot %d-byte objects each\n", NUM_ARENAS, OBJECTS_PER_ARENA, OBJECT_SIZE);
+    run("uncolored", RK_ARENA_FLAG_NO_COLORING, counter);
+    run("colored", RK_ARENA_FLAG_NONE, counter);
+
+    return EXIT_SUCCESS;
+}
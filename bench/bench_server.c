@@ -0,0 +1,616 @@
+#define _GNU_SOURCE
+#define RK_ARENA_IMPLEMENTATION
+#include "../rkmemory/rkarena.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+// A loopback HTTP-ish server with per-connection and per-request memory,
+// driven by a closed-loop load generator in the same process. The allocator
+// is picked at build time:
+//
+//      -DBENCH_ALLOC_MALLOC    malloc/free for everything
+//      -DBENCH_ALLOC_ARENA     rkCreateArena/rkFreeArena per connection/request
+//      -DBENCH_ALLOC_POOL      arenas acquired from an rkArenaPool (default)
+
+#if defined(BENCH_ALLOC_MALLOC)
+#    define BENCH_ALLOC_NAME "malloc"
+#elif defined(BENCH_ALLOC_ARENA)
+#    define BENCH_ALLOC_NAME "arena"
+#else
+#    if !defined(BENCH_ALLOC_POOL)
+#        define BENCH_ALLOC_POOL
+#    endif
+#    define BENCH_ALLOC_NAME "pool"
+#endif
+
+#define READ_BUFFER_SIZE 4096
+#define MAX_HEADERS 32
+#define MAX_EVENTS 256
+#define NUM_REQUEST_HEADERS 12
+
+// --- allocation front end ---------------------------------------------------
+
+#if defined(BENCH_ALLOC_POOL)
+static rkArenaPool *connPool = NULL;
+static rkArenaPool *requestPool = NULL;
+#endif
+
+typedef struct Scope
+{
+#if defined(BENCH_ALLOC_MALLOC)
+    void  *blocks[2 * MAX_HEADERS + 8]; // Every block malloc'd in the scope
+    size_t numBlocks;                   // The number of blocks
+#else
+    rkArena *arena; // The arena backing the scope
+#endif
+} Scope;
+
+static int scopeOpen(Scope *scope, int perRequest)
+{
+#if defined(BENCH_ALLOC_MALLOC)
+    (void)perRequest;
+    scope->numBlocks = 0;
+    return 1;
+#elif defined(BENCH_ALLOC_ARENA)
+    (void)perRequest;
+    scope->arena = rkCreateArena();
+    return scope->arena != NULL;
+#else
+    scope->arena = rkArenaPoolAcquire(perRequest ? requestPool : connPool);
+    return scope->arena != NULL;
+#endif
+}
+
+static void *scopeAlloc(Scope *scope, size_t numBytes)
+{
+#if defined(BENCH_ALLOC_MALLOC)
+    if (scope->numBlocks == sizeof(scope->blocks) / sizeof(scope->blocks[0]))
+    {
+        return NULL;
+    }
+
+    void *const ptr = malloc(numBytes);
+    scope->blocks[scope->numBlocks++] = ptr;
+    return ptr;
+#else
+    return rkArenaAlloc(scope->arena, numBytes);
+#endif
+}
+
+static void scopeClose(Scope *scope, int perRequest)
+{
+#if defined(BENCH_ALLOC_MALLOC)
+    (void)perRequest;
+    for (size_t i = 0; i < scope->numBlocks; i++)
+    {
+        free(scope->blocks[i]);
+    }
+#elif defined(BENCH_ALLOC_ARENA)
+    (void)perRequest;
+    rkFreeArena(scope->arena);
+#else
+    rkArenaPoolRelease(perRequest ? requestPool : connPool, scope->arena);
+#endif
+}
+
+// --- server -----------------------------------------------------------------
+
+typedef struct Connection
+{
+    Scope  scope;                    // The memory of the connection
+    int    fd;                       // The socket
+    char  *buffer;                   // The request bytes read so far
+    size_t length;                   // The number of bytes in `buffer`
+    size_t served;                   // The number of requests served
+} Connection;
+
+typedef struct Header
+{
+    char *name;  // The header name
+    char *value; // The header value
+} Header;
+
+static volatile int running = 1;
+
+static char *copyString(Scope *scope, const char *start, size_t len)
+{
+    char *const str = (char *)scopeAlloc(scope, len + 1);
+    if (str)
+    {
+        memcpy(str, start, len);
+        str[len] = '\0';
+    }
+
+    return str;
+}
+
+static Connection *openConnection(int fd)
+{
+    Scope scope;
+    if (!scopeOpen(&scope, 0))
+    {
+        return NULL;
+    }
+
+    Connection *const conn = (Connection *)scopeAlloc(&scope, sizeof(Connection));
+    char *const buffer = (char *)scopeAlloc(&scope, READ_BUFFER_SIZE);
+    if (!conn || !buffer)
+    {
+        scopeClose(&scope, 0);
+        return NULL;
+    }
+
+    conn->scope = scope;
+    conn->fd = fd;
+    conn->buffer = buffer;
+    conn->length = 0;
+    conn->served = 0;
+    return conn;
+}
+
+static void closeConnection(Connection *conn)
+{
+    close(conn->fd);
+
+    Scope scope = conn->scope;
+    scopeClose(&scope, 0);
+}
+
+static int writeAll(int fd, const char *data, size_t len)
+{
+    while (len > 0)
+    {
+        const ssize_t n = write(fd, data, len);
+        if (n < 0)
+        {
+            if (errno == EAGAIN || errno == EINTR)
+            {
+                continue;
+            }
+
+            return 0;
+        }
+
+        data += n;
+        len -= (size_t)n;
+    }
+
+    return 1;
+}
+
+// Parses one request into per-request memory and writes the response
+static int serveRequest(Connection *conn, const char *request, size_t len)
+{
+    Scope scope;
+    if (!scopeOpen(&scope, 1))
+    {
+        return 0;
+    }
+
+    const char *const lineEnd = memchr(request, '\r', len);
+    const char *const pathStart = lineEnd ? memchr(request, ' ', (size_t)(lineEnd - request)) : NULL;
+    const char *const pathEnd = pathStart ? memchr(pathStart + 1, ' ', (size_t)(lineEnd - pathStart - 1)) : NULL;
+    if (!pathEnd)
+    {
+        scopeClose(&scope, 1);
+        return 0;
+    }
+
+    char *const path = copyString(&scope, pathStart + 1, (size_t)(pathEnd - pathStart - 1));
+    Header *const headers = (Header *)scopeAlloc(&scope, MAX_HEADERS * sizeof(Header));
+    size_t numHeaders = 0;
+
+    const char *p = lineEnd + 2;
+    const char *const end = request + len;
+    while (headers && p < end && numHeaders < MAX_HEADERS)
+    {
+        const char *const eol = memchr(p, '\r', (size_t)(end - p));
+        if (!eol || eol == p)
+        {
+            break;
+        }
+
+        const char *const colon = memchr(p, ':', (size_t)(eol - p));
+        if (colon)
+        {
+            headers[numHeaders].name = copyString(&scope, p, (size_t)(colon - p));
+            headers[numHeaders].value = copyString(&scope, colon + 2, (size_t)(eol - colon - 2));
+            numHeaders++;
+        }
+
+        p = eol + 2;
+    }
+
+    char *const body = (char *)scopeAlloc(&scope, 1024);
+    char *const response = (char *)scopeAlloc(&scope, 1200);
+    if (!path || !headers || !body || !response)
+    {
+        scopeClose(&scope, 1);
+        return 0;
+    }
+
+    int bodyLen = snprintf(body, 1024, "path=%s headers=%zu served=%zu\n", path, numHeaders, conn->served);
+    for (size_t i = 0; i < numHeaders && bodyLen < 900; i++)
+    {
+        bodyLen += snprintf(body + bodyLen, 1024 - (size_t)bodyLen, "%s=%zu\n", headers[i].name, strlen(headers[i].value));
+    }
+
+    const int responseLen = snprintf(response, 1200, "HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n%s", bodyLen, body);
+
+    const int ok = writeAll(conn->fd, response, (size_t)responseLen);
+    conn->served++;
+
+    scopeClose(&scope, 1);
+    return ok;
+}
+
+static int handleReadable(Connection *conn)
+{
+    for (;;)
+    {
+        const ssize_t n = read(conn->fd, conn->buffer + conn->length, READ_BUFFER_SIZE - conn->length);
+        if (n == 0)
+        {
+            return 0;
+        }
+        if (n < 0)
+        {
+            return errno == EAGAIN || errno == EINTR;
+        }
+
+        conn->length += (size_t)n;
+
+        char *start = conn->buffer;
+        char *terminator;
+        while ((terminator = memmem(start, conn->length - (size_t)(start - conn->buffer), "\r\n\r\n", 4)))
+        {
+            if (!serveRequest(conn, start, (size_t)(terminator - start) + 4))
+            {
+                return 0;
+            }
+
+            start = terminator + 4;
+        }
+
+        conn->length -= (size_t)(start - conn->buffer);
+        memmove(conn->buffer, start, conn->length);
+        if (conn->length == READ_BUFFER_SIZE)
+        {
+            return 0;
+        }
+    }
+}
+
+static void *serverMain(void *arg)
+{
+    const int listener = *(int *)arg;
+    const int epfd = epoll_create1(0);
+
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = NULL };
+    epoll_ctl(epfd, EPOLL_CTL_ADD, listener, &ev);
+
+    struct epoll_event events[MAX_EVENTS];
+    while (running)
+    {
+        const int n = epoll_wait(epfd, events, MAX_EVENTS, 50);
+        for (int i = 0; i < n; i++)
+        {
+            Connection *const conn = (Connection *)events[i].data.ptr;
+            if (!conn)
+            {
+                int fd;
+                while ((fd = accept4(listener, NULL, NULL, SOCK_NONBLOCK)) >= 0)
+                {
+                    const int one = 1;
+                    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+                    Connection *const accepted = openConnection(fd);
+                    if (!accepted)
+                    {
+                        close(fd);
+                        continue;
+                    }
+
+                    struct epoll_event cev = { .events = EPOLLIN, .data.ptr = accepted };
+                    epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &cev);
+                }
+
+                continue;
+            }
+
+            if (!handleReadable(conn))
+            {
+                epoll_ctl(epfd, EPOLL_CTL_DEL, conn->fd, NULL);
+                closeConnection(conn);
+            }
+        }
+    }
+
+    close(epfd);
+    return NULL;
+}
+
+// --- load generator ---------------------------------------------------------
+
+typedef struct ClientConn
+{
+    int      fd;       // The socket
+    uint64_t sentAt;   // When the outstanding request was sent, in ns
+    size_t   received; // The number of response bytes received so far
+    char     buffer[2048];
+} ClientConn;
+
+typedef struct Client
+{
+    pthread_t  thread;         // The load generator thread
+    int        numConns;       // The number of connections to drive
+    uint16_t   port;           // The server port
+    uint64_t  *latencies;      // The recorded latencies in ns
+    size_t     numLatencies;   // The number of recorded latencies
+    size_t     capLatencies;   // The capacity of `latencies`
+    size_t     reconnects;     // Connections opened after the first ones
+} Client;
+
+static uint64_t nowNanos(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int connectTo(uint16_t port)
+{
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    const int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+static int sendRequest(ClientConn *conn, size_t seq)
+{
+    char request[1024];
+    int len = snprintf(request, sizeof(request), "GET /items/%zu HTTP/1.1\r\nHost: localhost\r\n", seq);
+    for (int i = 0; i < NUM_REQUEST_HEADERS; i++)
+    {
+        len += snprintf(request + len, sizeof(request) - (size_t)len, "X-Header-%d: value-%zu-%d\r\n", i, seq, i);
+    }
+    len += snprintf(request + len, sizeof(request) - (size_t)len, "\r\n");
+
+    conn->sentAt = nowNanos();
+    conn->received = 0;
+    return writeAll(conn->fd, request, (size_t)len);
+}
+
+// Returns 1 once the full response has been received
+static int responseComplete(const ClientConn *conn)
+{
+    const char *const headerEnd = memmem(conn->buffer, conn->received, "\r\n\r\n", 4);
+    if (!headerEnd)
+    {
+        return 0;
+    }
+
+    const char *const cl = memmem(conn->buffer, (size_t)(headerEnd - conn->buffer), "Content-Length: ", 16);
+    const size_t bodyLen = cl ? strtoul(cl + 16, NULL, 10) : 0;
+    return conn->received >= (size_t)(headerEnd + 4 - conn->buffer) + bodyLen;
+}
+
+static void *clientMain(void *arg)
+{
+    Client *const client = (Client *)arg;
+    const int epfd = epoll_create1(0);
+
+    ClientConn *const conns = (ClientConn *)calloc((size_t)client->numConns, sizeof(ClientConn));
+    size_t seq = 0;
+    for (int i = 0; i < client->numConns; i++)
+    {
+        conns[i].fd = connectTo(client->port);
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &conns[i] };
+        epoll_ctl(epfd, EPOLL_CTL_ADD, conns[i].fd, &ev);
+        sendRequest(&conns[i], seq++);
+    }
+
+    struct epoll_event events[MAX_EVENTS];
+    while (running)
+    {
+        const int n = epoll_wait(epfd, events, MAX_EVENTS, 50);
+        for (int i = 0; i < n; i++)
+        {
+            ClientConn *const conn = (ClientConn *)events[i].data.ptr;
+            const ssize_t r = read(conn->fd, conn->buffer + conn->received, sizeof(conn->buffer) - conn->received);
+            if (r <= 0)
+            {
+                continue;
+            }
+
+            conn->received += (size_t)r;
+            if (!responseComplete(conn))
+            {
+                continue;
+            }
+
+            if (client->numLatencies == client->capLatencies)
+            {
+                client->capLatencies = client->capLatencies ? client->capLatencies * 2 : 1 << 16;
+                client->latencies = (uint64_t *)realloc(client->latencies, client->capLatencies * sizeof(uint64_t));
+            }
+            client->latencies[client->numLatencies++] = nowNanos() - conn->sentAt;
+
+            // Every 64th request the connection is replaced, so connection
+            // setup and teardown is part of the workload as well
+            if (seq % 64 == 0)
+            {
+                epoll_ctl(epfd, EPOLL_CTL_DEL, conn->fd, NULL);
+                close(conn->fd);
+                conn->fd = connectTo(client->port);
+                struct epoll_event ev = { .events = EPOLLIN, .data.ptr = conn };
+                epoll_ctl(epfd, EPOLL_CTL_ADD, conn->fd, &ev);
+                client->reconnects++;
+            }
+
+            sendRequest(conn, seq++);
+        }
+    }
+
+    for (int i = 0; i < client->numConns; i++)
+    {
+        close(conns[i].fd);
+    }
+
+    free(conns);
+    close(epfd);
+    return NULL;
+}
+
+// --- reporting --------------------------------------------------------------
+
+static int compareLatency(const void *a, const void *b)
+{
+    const uint64_t x = *(const uint64_t *)a;
+    const uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const uint64_t *sorted, size_t n, double p)
+{
+    if (n == 0)
+    {
+        return 0.0;
+    }
+
+    size_t i = (size_t)(p * (double)n);
+    if (i >= n)
+    {
+        i = n - 1;
+    }
+
+    return (double)sorted[i] / 1000.0;
+}
+
+static long readStatusKb(const char *key)
+{
+    FILE *const file = fopen("/proc/self/status", "r");
+    if (!file)
+    {
+        return -1;
+    }
+
+    char line[256];
+    long value = -1;
+    const size_t keyLen = strlen(key);
+    while (fgets(line, sizeof(line), file))
+    {
+        if (strncmp(line, key, keyLen) == 0)
+        {
+            value = strtol(line + keyLen, NULL, 10);
+            break;
+        }
+    }
+
+    fclose(file);
+    return value;
+}
+
+int main(int argc, char **argv)
+{
+    const int seconds = argc > 1 ? atoi(argv[1]) : 5;
+    const int numClients = argc > 2 ? atoi(argv[2]) : 2;
+    const int connsPerClient = argc > 3 ? atoi(argv[3]) : 32;
+
+#if defined(BENCH_ALLOC_POOL)
+    connPool = rkCreateArenaPool(8 * 1024, RK_ARENA_FLAG_NONE, 1, 0);
+    requestPool = rkCreateArenaPool(8 * 1024, RK_ARENA_FLAG_NONE, 1, 0);
+#endif
+
+    const int listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    const int one = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    socklen_t addrLen = sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listener, 1024) != 0)
+    {
+        perror("listen");
+        return EXIT_FAILURE;
+    }
+    getsockname(listener, (struct sockaddr *)&addr, &addrLen);
+
+    pthread_t server;
+    pthread_create(&server, NULL, serverMain, (void *)&listener);
+
+    Client *const clients = (Client *)calloc((size_t)numClients, sizeof(Client));
+    const uint64_t start = nowNanos();
+    for (int i = 0; i < numClients; i++)
+    {
+        clients[i].numConns = connsPerClient;
+        clients[i].port = ntohs(addr.sin_port);
+        pthread_create(&clients[i].thread, NULL, clientMain, &clients[i]);
+    }
+
+    sleep((unsigned)seconds);
+    running = 0;
+
+    size_t total = 0;
+    size_t reconnects = 0;
+    for (int i = 0; i < numClients; i++)
+    {
+        pthread_join(clients[i].thread, NULL);
+        total += clients[i].numLatencies;
+        reconnects += clients[i].reconnects;
+    }
+    const double elapsed = (double)(nowNanos() - start) * 1e-9;
+    pthread_join(server, NULL);
+
+    uint64_t *const all = (uint64_t *)malloc((total ? total : 1) * sizeof(uint64_t));
+    size_t k = 0;
+    for (int i = 0; i < numClients; i++)
+    {
+        memcpy(all + k, clients[i].latencies, clients[i].numLatencies * sizeof(uint64_t));
+        k += clients[i].numLatencies;
+        free(clients[i].latencies);
+    }
+    qsort(all, total, sizeof(uint64_t), compareLatency);
+
+    printf("allocator=%s clients=%d conns=%d seconds=%.1f\n", BENCH_ALLOC_NAME, numClients, numClients * connsPerClient, elapsed);
+    printf("requests=%zu reconnects=%zu rps=%.0f\n", total, reconnects, (double)total / elapsed);
+    printf("latency p50=%.1fus p99=%.1fus p999=%.1fus\n", percentile(all, total, 0.50), percentile(all, total, 0.99), percentile(all, total, 0.999));
+    printf("rss=%ldKB peak_rss=%ldKB\n", readStatusKb("VmRSS:"), readStatusKb("VmHWM:"));
+
+    free(all);
+    free(clients);
+    close(listener);
+
+#if defined(BENCH_ALLOC_POOL)
+    rkFreeArenaPool(connPool);
+    rkFreeArenaPool(requestPool);
+#endif
+
+    return EXIT_SUCCESS;
+}
@@ -8,6 +8,98 @@
 // Handle to the memory arena
 typedef struct rkArena rkArena;
 
+// Handle to a pool of reusable arenas
+typedef struct rkArenaPool rkArenaPool;
+
+/**
+ * The flags an arena can be created with
+ */
+typedef enum rkArenaFlags
+{
+    RK_ARENA_FLAG_NONE        = 0,      // The default behaviour
+    RK_ARENA_FLAG_NO_COLORING = 1 << 0, // Start every page at the same cache color, mapped at its exact size
+    RK_ARENA_FLAG_PREFETCH    = 1 << 1, // Prefetch and pre-fault ahead of the bump pointer
+    RK_ARENA_FLAG_REFCOUNT    = 1 << 2, // Count live allocations per page for `rkArenaRelease`
+    RK_ARENA_FLAG_DIRECT_IO   = 1 << 3, // Align every allocation and its size to 4KB blocks for `O_DIRECT`
+    RK_ARENA_FLAG_DONTFORK    = 1 << 4, // Leave the pages out of children created with `fork`
+    RK_ARENA_FLAG_WIPEONFORK  = 1 << 5, // Hand children created with `fork` zeroed pages instead of copies
+    RK_ARENA_FLAG_COMPRESS    = 1 << 6  // Compress pages that go untouched, see `rkArenaCompressCold`
+} rkArenaFlags;
+
+/**
+ * Lifetime and access hints that route allocations to separate page chains
+ * within one arena, so that data with different lifetimes or access patterns
+ * does not share pages
+ */
+typedef enum rkArenaHint
+{
+    RK_NORMAL,          // No particular lifetime or access pattern
+    RK_HOT,             // Frequently accessed data
+    RK_COLD,            // Rarely accessed data, e.g. metadata
+    RK_SHORT,           // Short-lived data that is reset on its own
+    RK_LONG,            // Data that lives as long as the arena
+    RK_ARENA_HINT_COUNT // The number of hints
+} rkArenaHint;
+
+/**
+ * A snapshot of the memory usage of an arena
+ */
+typedef struct rkArenaStats
+{
+    size_t pageCount;        // The number of pages in use
+    size_t cachedPageCount;  // The number of pages retained in the page cache
+    size_t capacityBytes;    // The total capacity of the pages in use
+    size_t cachedBytes;      // The total capacity of the cached pages
+    size_t usedBytes;        // The number of bytes handed out since the last reset
+    size_t wastedBytes;      // Free bytes at the end of retired pages that will never be used
+    size_t tailFreeBytes;    // Free bytes at the end of retired pages kept for reuse
+    size_t tailReusedBytes;  // Bytes served from retired page tails since the last reset
+    size_t packedPageCount;  // The number of pages held compressed
+    size_t packedBytes;      // The size of the compressed copies of those pages
+    size_t spilledPageCount; // The number of pages moved to the spill file
+    size_t spilledBytes;     // The capacity of those pages
+} rkArenaStats;
+
+/**
+ * A region of arena memory to write out
+ */
+typedef struct rkArenaRegion
+{
+    const void *data; // The start of the region
+    size_t      size; // The size of the region in bytes
+} rkArenaRegion;
+
+/**
+ * The flags `rkArenaWritev` can be called with
+ */
+typedef enum rkArenaWriteFlags
+{
+    RK_ARENA_WRITE_NONE = 0,     // Write the regions with `writev`
+    RK_ARENA_WRITE_GIFT = 1 << 0 // Splice the regions into a pipe with `vmsplice`
+} rkArenaWriteFlags;
+
+/**
+ * The results of the kernel's same-page merging, or `-1` for every counter
+ * the kernel does not expose
+ */
+typedef struct rkArenaKsmStats
+{
+    long mergingPages; // Pages of this process currently merged with identical ones
+    long pagesShared;  // Merged pages in use across the system
+    long pagesSharing; // Pages across the system that were deduplicated into those
+} rkArenaKsmStats;
+
+/**
+ * The NUMA placement policies that can be applied to the pages of an arena
+ */
+typedef enum rkArenaNumaPolicy
+{
+    RK_ARENA_NUMA_DEFAULT,    // Follow the memory policy of the process
+    RK_ARENA_NUMA_BIND,       // Place all pages on a single node
+    RK_ARENA_NUMA_INTERLEAVE, // Interleave pages across all online nodes
+    RK_ARENA_NUMA_FIRST_TOUCH // Place pages on the node of the first toucher
+} rkArenaNumaPolicy;
+
 // --- arena interface --------------------------------------------------------
 
 /**
@@ -29,6 +121,20 @@ rkArena *rkCreateArena(void);
  */
 rkArena *rkCreateArenaWithPageSize(size_t pageSize);
 
+/**
+ * Creates an arena with a specified page size and behaviour flags
+ *
+ * @param[in] pageSize
+ *      The size of the pages in bytes
+ * @param[in] flags
+ *      A combination of `rkArenaFlags`
+ *
+ * @return
+ *      A pointer to the newly created arena, or `NULL` upon failure, e.g. if
+ *      64 arenas with `RK_ARENA_FLAG_COMPRESS` exist already
+ */
+rkArena *rkCreateArenaWithFlags(size_t pageSize, unsigned flags);
+
 /**
  * Frees the arena and all the memory allocated within it
  *
@@ -38,13 +144,55 @@ rkArena *rkCreateArenaWithPageSize(size_t pageSize);
 void rkFreeArena(rkArena *arena);
 
 /**
- * Resets the arena marker to the beginning of the allocated pages
+ * Resets the arena marker to the beginning of the allocated pages. Pages
+ * beyond the first are retained in the arena's page cache and are reused by
+ * subsequent allocations before any new pages are requested from the OS
  *
  * @param[in] arena
  *      A pointer to the arena to reset
  */
 void rkResetArena(rkArena *arena);
 
+/**
+ * Resets only the page chain of `hint`, leaving the allocations made with
+ * other hints intact. The chain's pages beyond its current one are retained
+ * in the arena's page cache
+ *
+ * @param[in] arena
+ *      A pointer to the arena to reset
+ * @param[in] hint
+ *      The hint whose allocations to discard
+ */
+void rkResetArenaHint(rkArena *arena, rkArenaHint hint);
+
+/**
+ * Releases pages retained in the arena's page cache back to the OS until at
+ * most `keepBytes` bytes of cached page capacity remain
+ *
+ * @param[in] arena
+ *      A pointer to the arena to trim
+ * @param[in] keepBytes
+ *      The amount of cached page capacity in bytes to keep around
+ *
+ * @return
+ *      The number of bytes released back to the OS
+ */
+size_t rkArenaTrim(rkArena *arena, size_t keepBytes);
+
+/**
+ * Asks the thread owning the arena to release its page cache, which it does
+ * on its next reset or the next time it needs a new page. Unlike
+ * `rkArenaTrim` this function is thread-safe, so that e.g. a pressure monitor
+ * thread may call it
+ *
+ * @param[in] arena
+ *      A pointer to the arena to trim
+ *
+ * @return
+ *      The number of bytes released by earlier requests since the last call
+ */
+size_t rkArenaRequestTrim(rkArena *arena);
+
 /**
  * Allocates `numBytes` bytes in `arena`
  *
@@ -58,6 +206,24 @@ void rkResetArena(rkArena *arena);
  */
 void *rkArenaAlloc(rkArena *arena, size_t numBytes);
 
+/**
+ * Allocates `numBytes` bytes in `arena` from the page chain of `hint`.
+ * `rkArenaAlloc` is equivalent to allocating with `RK_NORMAL`. Requests
+ * larger than the page size get a dedicated page of their own, which is
+ * released back to the OS when the chain is reset
+ *
+ * @param[in] arena
+ *      A pointer to the arena to allocate memory from
+ * @param[in] numBytes
+ *      The amount of bytes to allocate
+ * @param[in] hint
+ *      The lifetime or access hint of the allocation
+ *
+ * @return
+ *      A pointer to the start of the allocated bytes, or `NULL` upon failure
+ */
+void *rkArenaAllocHint(rkArena *arena, size_t numBytes, rkArenaHint hint);
+
 /**
  * Allocates `numBytes` bytes in the `arena` and initializes the requested
  * region to `0x00`
@@ -73,7 +239,83 @@ void *rkArenaAlloc(rkArena *arena, size_t numBytes);
 void *rkArenaAllocZeroed(rkArena *arena, size_t numBytes);
 
 /**
- * Resizes the region at `ptr` by `numBytes`
+ * Reserves one contiguous region for `n` slices of `counts[i]` elements each
+ * and splits it up by an exclusive prefix sum, so that the slices can be
+ * filled by different threads without touching the arena again. Empty slices
+ * get a pointer to where they would start
+ *
+ * @param[in] arena
+ *      A pointer to the arena to allocate memory from
+ * @param[in] counts
+ *      The number of elements of every slice
+ * @param[in] n
+ *      The number of slices
+ * @param[in] elemSize
+ *      The size of an element in bytes
+ * @param[out] out
+ *      The `n` slice pointers to populate, which are all `NULL` if no
+ *      elements were requested at all
+ *
+ * @return
+ *      `1` upon success, or `0` upon failure
+ */
+int rkArenaReserveSlices(rkArena *arena, const size_t *counts, size_t n, size_t elemSize, void **out);
+
+/**
+ * Moves every allocation of `src` into `dst` by handing the page descriptors
+ * of `src` over to `dst`, in O(n_src + n_dst) time for the page counts of the
+ * two arenas. Only the descriptors and page index entries are moved, no
+ * allocation is copied. The allocations live as long as `dst` from then on,
+ * while `src` is left empty but usable. Pages cached by `src` stay with
+ * `src`. Both arenas must have the same page size and agree on
+ * `RK_ARENA_FLAG_DIRECT_IO` and `RK_ARENA_FLAG_REFCOUNT`, so that the pages
+ * keep the guarantees of `dst`
+ *
+ * @param[in] dst
+ *      A pointer to the arena that takes over the allocations
+ * @param[in] src
+ *      A pointer to the arena to empty
+ *
+ * @return
+ *      `1` upon success, or `0` if the arenas are incompatible, the page
+ *      table of `dst` could not grow, either arena is frozen or `src` spilled
+ *      pages to its spill file, in which case both arenas are left untouched
+ */
+int rkArenaAbsorb(rkArena *dst, rkArena *src);
+
+/**
+ * Checks whether `ptr` points into an allocation made in `arena`. The pages
+ * are looked up in an index sorted by address, so the cost grows with the
+ * logarithm of the page count
+ *
+ * @param[in] arena
+ *      A pointer to the arena
+ * @param[in] ptr
+ *      The pointer to check
+ *
+ * @return
+ *      `1` if `ptr` lies within the allocated bytes of one of the arena's
+ *      pages, or `0` otherwise
+ */
+int rkArenaOwns(const rkArena *arena, const void *ptr);
+
+/**
+ * Releases a single allocation of an arena created with
+ * `RK_ARENA_FLAG_REFCOUNT`. Once every allocation of a page has been
+ * released, the page goes back to the page cache, or is rewound if it is
+ * the current page of its chain, while the arena itself lives on
+ *
+ * @param[in] arena
+ *      A pointer to the arena the allocation was made in
+ * @param[in] ptr
+ *      A pointer to the start of the allocation, may be `NULL`
+ */
+void rkArenaRelease(rkArena *arena, void *ptr);
+
+/**
+ * Resizes the region at `ptr` by `numBytes`. Allocations larger than the page
+ * size own a dedicated mapping, which is grown by remapping it on Linux
+ * rather than by copying its contents
  *
  * @param[in] arena
  *      A pointer to the arena to reallocate in
@@ -83,9 +325,337 @@ void *rkArenaAllocZeroed(rkArena *arena, size_t numBytes);
  *      The original size in bytes of the region
  * @param[in] newSize
  *      The new size in bytes of the region
+ *
+ * @return
+ *      A pointer to the resized region, or `NULL` upon failure. With
+ *      `RK_ARENA_FLAG_REFCOUNT` the old region is released
  */
 void *rkArenaRealloc(rkArena *arena, void *ptr, size_t oldSize, size_t newSize);
 
+/**
+ * Reads a whole file into arena memory. With `RK_ARENA_FLAG_DIRECT_IO` the
+ * file is opened with `O_DIRECT` where the file system supports it, so that
+ * large block aligned reads land in the arena without going through the page
+ * cache. Memory of a failed read is reclaimed by the next reset
+ *
+ * @param[in] arena
+ *      A pointer to the arena to read into
+ * @param[in] path
+ *      The path of the file to read
+ * @param[out] size
+ *      The number of bytes read, may be `NULL`
+ *
+ * @return
+ *      A pointer to the contents of the file, or `NULL` upon failure
+ */
+void *rkArenaReadFile(rkArena *arena, const char *path, size_t *size);
+
+/**
+ * Maps a whole file read-only into the lifetime of the arena, so that parsers
+ * can point into its contents without copying them. The mapping is advised
+ * for sequential access and is unmapped by the next reset of `RK_NORMAL`, by
+ * freeing the arena, or by releasing it with `RK_ARENA_FLAG_REFCOUNT`. On
+ * platforms without `mmap` the file is read instead
+ *
+ * @param[in] arena
+ *      A pointer to the arena that owns the mapping
+ * @param[in] path
+ *      The path of the file to map
+ * @param[out] size
+ *      The size of the file in bytes, may be `NULL`
+ *
+ * @return
+ *      A pointer to the contents of the file, or `NULL` upon failure or if
+ *      the file is empty
+ */
+const void *rkArenaMapFile(rkArena *arena, const char *path, size_t *size);
+
+/**
+ * Writes a sequence of arena regions to a file descriptor with as few
+ * `writev` calls as possible, without copying them into a contiguous buffer
+ * first. Regions that follow each other in memory, such as consecutive
+ * allocations, are merged into one I/O vector. With `RK_ARENA_WRITE_GIFT` the
+ * pages are spliced into a pipe instead, in which case the regions must not
+ * be modified, nor the arena reset, until the reader has drained the pipe
+ *
+ * @param[in] arena
+ *      A pointer to the arena the regions were allocated in
+ * @param[in] fd
+ *      The file descriptor to write to, a pipe with `RK_ARENA_WRITE_GIFT`
+ * @param[in] regions
+ *      The regions to write, in order
+ * @param[in] n
+ *      The number of regions
+ * @param[in] flags
+ *      A combination of `rkArenaWriteFlags`
+ *
+ * @return
+ *      The number of bytes written, which falls short of the total size of
+ *      the regions if `fd` would block or an error occurred, as told by
+ *      `errno`
+ */
+size_t rkArenaWritev(rkArena *arena, int fd, const rkArenaRegion *regions, size_t n, unsigned flags);
+
+/**
+ * Reads up to `maxBytes` bytes from a file descriptor straight into the free
+ * space of the current `RK_NORMAL` page, and commits only the bytes that were
+ * actually read. The arena moves on to a new page first if the current one
+ * has less than `maxBytes` bytes left, and reads of more than a page go to a
+ * dedicated page whose unused end is kept for reuse
+ *
+ * @param[in] arena
+ *      A pointer to the arena to read into
+ * @param[in] fd
+ *      The file descriptor to read from
+ * @param[in] maxBytes
+ *      The maximum number of bytes to read
+ * @param[out] numRead
+ *      The number of bytes read, `0` at the end of the file
+ *
+ * @return
+ *      A pointer to the bytes read, or `NULL` upon failure, as told by `errno`
+ */
+void *rkArenaRead(rkArena *arena, int fd, size_t maxBytes, size_t *numRead);
+
+/**
+ * Receives up to `maxBytes` bytes from a socket straight into arena memory,
+ * in the same way as `rkArenaRead`
+ *
+ * @param[in] arena
+ *      A pointer to the arena to receive into
+ * @param[in] fd
+ *      The socket to receive from
+ * @param[in] maxBytes
+ *      The maximum number of bytes to receive
+ * @param[in] flags
+ *      The `MSG_XXX` flags to pass to `recv`
+ * @param[out] numRead
+ *      The number of bytes received, `0` once the peer shut down
+ *
+ * @return
+ *      A pointer to the bytes received, or `NULL` upon failure, as told by
+ *      `errno`
+ */
+void *rkArenaRecv(rkArena *arena, int fd, size_t maxBytes, int flags, size_t *numRead);
+
+/**
+ * Collects the memory usage of the arena
+ *
+ * @param[in] arena
+ *      A pointer to the arena
+ * @param[out] stats
+ *      The stats to populate
+ */
+void rkArenaGetStats(const rkArena *arena, rkArenaStats *stats);
+
+/**
+ * Makes the pages in use by the arena read-only, e.g. once a reference table
+ * is built. Allocating from a frozen arena fails until it is thawed, which
+ * resetting it does as well. Mergeable pages are offered to the kernel's
+ * same-page merging, so that identical tables built by different processes
+ * share physical memory
+ *
+ * @param[in] arena
+ *      A pointer to the arena to freeze
+ * @param[in] mergeable
+ *      Whether to mark the pages `MADV_MERGEABLE`. This is a hint that is
+ *      ignored where KSM is unavailable
+ *
+ * @return
+ *      `1` upon success, or `0` if the pages could not be protected, in which
+ *      case the arena is left writable
+ */
+int rkArenaFreeze(rkArena *arena, int mergeable);
+
+/**
+ * Makes the pages of a frozen arena writable again and withdraws them from
+ * same-page merging
+ *
+ * @param[in] arena
+ *      A pointer to the arena to thaw
+ */
+void rkArenaThaw(rkArena *arena);
+
+/**
+ * Reads the merge results of the kernel's same-page merging from `/proc` and
+ * `/sys/kernel/mm/ksm`
+ *
+ * @param[out] stats
+ *      The stats to populate
+ *
+ * @return
+ *      `1` if the merge results of this process are available, or `0`
+ *      otherwise
+ */
+int rkArenaGetKsmStats(rkArenaKsmStats *stats);
+
+/**
+ * Compresses the pages of an arena created with `RK_ARENA_FLAG_COMPRESS` that
+ * were not touched for `intervalMs` milliseconds, and returns their memory to
+ * the OS. Every call makes the pages in use inaccessible, so that the next
+ * access to one of them faults and marks it as touched again. Pages that
+ * stayed inaccessible for the interval are compressed with an in-tree LZ
+ * codec, and are decompressed transparently by the fault on their next
+ * access. Call this periodically, e.g. from the thread that owns the arena.
+ *
+ * Other threads may read and write the arena's memory while this runs, as
+ * the fault handler only makes a page accessible once its contents are
+ * complete, but the arena functions themselves are still reserved to the
+ * owning thread. The arena functions make pages accessible before handing
+ * them to the kernel, but arena memory passed to syscalls directly has to be
+ * touched first, since the kernel reports `EFAULT` instead of faulting. Only
+ * Linux is supported, where at most 64 arenas with `RK_ARENA_FLAG_COMPRESS`
+ * can exist at once and creating another one fails. Elsewhere the flag is
+ * ignored
+ *
+ * @param[in] arena
+ *      A pointer to the arena to scan
+ * @param[in] intervalMs
+ *      How long a page has to go untouched to be compressed
+ *
+ * @return
+ *      The number of bytes released by compressing pages
+ */
+size_t rkArenaCompressCold(rkArena *arena, unsigned intervalMs);
+
+/**
+ * Gives the arena a spill file in `directory` and a budget for its resident
+ * memory. Whenever a new page would take the arena over budget, its page
+ * cache is trimmed first, and then the pages allocated from least recently
+ * are moved into the spill file. Spilled pages keep their addresses and
+ * contents, but are backed by the file, so that the kernel can write them
+ * back and evict them instead of running out of memory. Calling this again
+ * only changes the budget. Only Linux is supported
+ *
+ * @param[in] arena
+ *      A pointer to the arena
+ * @param[in] directory
+ *      The directory to create the unlinked spill file in
+ * @param[in] residentBudget
+ *      The number of bytes of anonymous memory the arena may hold
+ *
+ * @return
+ *      `1` upon success, or `0` if the spill file could not be created
+ */
+int rkArenaSetSpill(rkArena *arena, const char *directory, size_t residentBudget);
+
+/**
+ * Sets the NUMA placement policy of the arena. The policy is applied to the
+ * pages the arena already owns (migrating them if needed) and to every page
+ * requested afterwards. On single-node machines, and on platforms without
+ * NUMA support, every policy behaves like `RK_ARENA_NUMA_DEFAULT`. The
+ * topology is read when the policy is set, so a changed topology only takes
+ * effect once the policy is set again
+ *
+ * @param[in] arena
+ *      A pointer to the arena
+ * @param[in] policy
+ *      The placement policy
+ * @param[in] node
+ *      The node to bind to for `RK_ARENA_NUMA_BIND`, ignored otherwise
+ *
+ * @return
+ *      `1` upon success, or `0` if `node` is not an online node
+ */
+int rkArenaSetNumaPolicy(rkArena *arena, rkArenaNumaPolicy policy, int node);
+
+/**
+ * Overrides the file the NUMA topology is read from. The file has to be in
+ * the sysfs node list format, e.g. `0-1` or `0,2-3`, which allows faking a
+ * topology for testing
+ *
+ * @param[in] onlinePath
+ *      The path to the node list, or `NULL` for
+ *      `/sys/devices/system/node/online`
+ */
+void rkArenaSetNumaTopology(const char *onlinePath);
+
+/**
+ * Gets the number of online NUMA nodes according to the current topology
+ *
+ * @return
+ *      The number of online nodes, which is at least `1`
+ */
+int rkArenaNumaNodeCount(void);
+
+/**
+ * Creates a pool of warm arenas for request-scoped use. Arenas handed out by
+ * the pool have their pages mapped and faulted in already, and are reset
+ * when they are released back into the pool
+ *
+ * @param[in] pageSize
+ *      The page size of the pooled arenas
+ * @param[in] flags
+ *      The `rkArenaFlags` of the pooled arenas
+ * @param[in] shapePages
+ *      If nonzero, new arenas are pre-faulted with this many pages, and
+ *      released arenas are trimmed back down to it
+ * @param[in] maxRetainedBytes
+ *      The maximum page capacity in bytes kept by idle arenas, or `0` for no
+ *      limit. Arenas released beyond the limit are freed
+ *
+ * @return
+ *      A pointer to the newly created pool, or `NULL` upon failure
+ */
+rkArenaPool *rkCreateArenaPool(size_t pageSize, unsigned flags, size_t shapePages, size_t maxRetainedBytes);
+
+/**
+ * Frees the pool and every idle arena in it. Arenas that are still acquired
+ * have to be freed with `rkFreeArena` by their owners
+ *
+ * @param[in] pool
+ *      A pointer to the pool to deallocate
+ */
+void rkFreeArenaPool(rkArenaPool *pool);
+
+/**
+ * Takes an idle arena from the pool, or creates a new one if the pool is
+ * empty. This function is thread-safe
+ *
+ * @param[in] pool
+ *      A pointer to the pool
+ *
+ * @return
+ *      A pointer to the arena, or `NULL` upon failure
+ */
+rkArena *rkArenaPoolAcquire(rkArenaPool *pool);
+
+/**
+ * Resets the arena and returns it to the pool. The arena must have been
+ * acquired from this pool. This function is thread-safe
+ *
+ * @param[in] pool
+ *      A pointer to the pool
+ * @param[in] arena
+ *      A pointer to the arena to release
+ */
+void rkArenaPoolRelease(rkArenaPool *pool, rkArena *arena);
+
+/**
+ * Frees idle arenas until at most `keepBytes` bytes of page capacity are
+ * retained by the pool. This function is thread-safe
+ *
+ * @param[in] pool
+ *      A pointer to the pool to trim
+ * @param[in] keepBytes
+ *      The amount of page capacity in bytes to keep around
+ *
+ * @return
+ *      The number of bytes released back to the OS
+ */
+size_t rkArenaPoolTrim(rkArenaPool *pool, size_t keepBytes);
+
+/**
+ * Gets the page capacity in bytes currently retained by idle arenas
+ *
+ * @param[in] pool
+ *      A pointer to the pool
+ *
+ * @return
+ *      The number of retained bytes
+ */
+size_t rkArenaPoolRetainedBytes(const rkArenaPool *pool);
+
 /**
  * Basic debugging function for testing use. This has to be removed before
  * making the library public
@@ -124,10 +694,21 @@ void rkDebugArena(const rkArena *arena);
 // --- platform dependent includes --------------------------------------------
 
 #if defined(RK_ARENA_PLATFORM_LINUX)
+#include <errno.h>
+#include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
 #elif defined(RK_ARENA_PLATFORM_WINDOWS)
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#include <io.h>
+#include <limits.h>
 #elif defined(RK_ARENA_PLATFORM_APPLE)
 #    error "Unimplemented: I don't own an apple device to test this with"
 #endif
@@ -136,8 +717,148 @@ void rkDebugArena(const rkArena *arena);
 
 #define DEFAULT_PAGE_SIZE (8 * 1024)
 
+// Pages are colored by shifting them by whole cache lines within the slack
+// that rounding the mapping up to the OS page size leaves. Regions that fill
+// whole OS pages have no slack and take one more OS page to be colored
+#define RK_ARENA_OS_PAGE_SIZE 4096
+#define RK_ARENA_CACHE_LINE 64
+#define RK_ARENA_CACHE_COLORS (RK_ARENA_OS_PAGE_SIZE / RK_ARENA_CACHE_LINE)
+
+// With `RK_ARENA_FLAG_PREFETCH`, the lines just past the bump pointer are
+// prefetched for writing and the next OS page is touched once the bump pointer
+// is this far into the current one
+#define RK_ARENA_PREFETCH_LINES 4
+#define RK_ARENA_TOUCH_THRESHOLD (RK_ARENA_OS_PAGE_SIZE / 2)
+
+// Retired pages with at least `RK_ARENA_MIN_TAIL` free bytes are kept in a
+// best-fit list. Requests of up to a quarter page are served from those tails
+// before the current page is bumped
+#define RK_ARENA_MAX_TAILS 8
+#define RK_ARENA_MIN_TAIL 64
+#define RK_ARENA_SMALL_ALLOC(pageSize) ((pageSize) / 4)
+
+// Owners of page table descriptors that do not belong to a chain, and the
+// descriptor that stands for no page at all
+#define RK_ARENA_PAGE_CACHED ((unsigned)RK_ARENA_HINT_COUNT)
+#define RK_ARENA_PAGE_UNUSED ((unsigned)RK_ARENA_HINT_COUNT + 1)
+#define RK_ARENA_NO_PAGE ((size_t)-1)
+
+// What backs the mapping of a page
+#define RK_ARENA_KIND_ANON 0 // Anonymous memory the arena allocates from
+#define RK_ARENA_KIND_FILE 1 // A read-only file mapped by `rkArenaMapFile`
+#define RK_ARENA_KIND_SPILLED 2 // Arena memory moved to the spill file
+
+// The number of independently locked free lists of an arena pool
+#define RK_ARENA_POOL_SHARDS 8
+
+#define RK_ARENA_NUMA_ONLINE_PATH "/sys/devices/system/node/online"
+#define RK_ARENA_MAX_NUMA_NODES 1024
+#define RK_ARENA_NUMA_MASK_BITS (8 * sizeof(unsigned long))
+#define RK_ARENA_NUMA_MASK_WORDS (RK_ARENA_MAX_NUMA_NODES / RK_ARENA_NUMA_MASK_BITS)
+
+// Memory policy modes and flags of the `mbind` syscall
+#define RK_ARENA_MPOL_DEFAULT    0
+#define RK_ARENA_MPOL_BIND       2
+#define RK_ARENA_MPOL_INTERLEAVE 3
+#define RK_ARENA_MPOL_LOCAL      4
+#define RK_ARENA_MPOL_MF_MOVE    (1 << 1)
+
+// Lets `mremap` move a mapping that cannot grow in place
+#define RK_ARENA_MREMAP_MAYMOVE 1
+#define RK_ARENA_MREMAP_FIXED   2
+
+// The `madvise` advice behind `RK_ARENA_FLAG_DONTFORK` and
+// `RK_ARENA_FLAG_WIPEONFORK`
+#define RK_ARENA_MADV_DONTFORK   10
+#define RK_ARENA_MADV_WIPEONFORK 18
+
+// The `madvise` advice that opts pages in and out of same-page merging, and
+// where the kernel reports its merge results
+#define RK_ARENA_MADV_MERGEABLE   12
+#define RK_ARENA_MADV_UNMERGEABLE 13
+
+// Spilled pages are advised cold, and their file space is released with
+// `fallocate` once they are unmapped
+#define RK_ARENA_MADV_COLD 20
+#define RK_ARENA_FALLOC_FL_KEEP_SIZE  0x01
+#define RK_ARENA_FALLOC_FL_PUNCH_HOLE 0x02
+#define RK_ARENA_SPILL_TEMPLATE "rkarena-spill-XXXXXX"
+#define RK_ARENA_KSM_PROCESS_PATH "/proc/self/ksm_merging_pages"
+#define RK_ARENA_KSM_SHARED_PATH  "/sys/kernel/mm/ksm/pages_shared"
+#define RK_ARENA_KSM_SHARING_PATH "/sys/kernel/mm/ksm/pages_sharing"
+
+// The number of arenas with `RK_ARENA_FLAG_COMPRESS` that can exist at once,
+// whose pages the fault handler looks up
+#define RK_ARENA_MAX_COLD_ARENAS 64
+
+// The states of a page under `RK_ARENA_FLAG_COMPRESS`
+#define RK_ARENA_COLD_HOT    0 // Accessible
+#define RK_ARENA_COLD_ARMED  1 // Inaccessible until the next access faults
+#define RK_ARENA_COLD_PACKED 2 // Compressed and released to the OS
+
+// The LZ codec finds matches of at least `RK_ARENA_LZ_MIN_MATCH` bytes within
+// the last 64KB through a hash table of `1 << RK_ARENA_LZ_HASH_BITS` entries
+#define RK_ARENA_LZ_MIN_MATCH 4
+#define RK_ARENA_LZ_MAX_OFFSET 65535
+#define RK_ARENA_LZ_HASH_BITS 12
+
+// The number of I/O vectors `rkArenaWritev` hands to a single syscall, and
+// the `vmsplice` flag that gifts the pages to the pipe
+#define RK_ARENA_IOV_BATCH 64
+#define RK_ARENA_SPLICE_F_GIFT 8
+
+// With `RK_ARENA_FLAG_DIRECT_IO`, allocations are rounded to the logical block
+// size `O_DIRECT` expects, and files are read in chunks of this many bytes
+#define RK_ARENA_DIRECT_BLOCK 4096
+#define RK_ARENA_DIRECT_CHUNK (1024 * 1024)
+
+// `O_DIRECT` is only declared with `_GNU_SOURCE`, and its value depends on the
+// architecture
+#if defined(O_DIRECT)
+#define RK_ARENA_O_DIRECT O_DIRECT
+#elif defined(__x86_64__) || defined(__i386__)
+#define RK_ARENA_O_DIRECT 040000
+#elif defined(__aarch64__) || defined(__arm__)
+#define RK_ARENA_O_DIRECT 0200000
+#else
+#define RK_ARENA_O_DIRECT 0
+#endif
+
 // --- macros -----------------------------------------------------------------
 
+#if defined(_MSC_VER)
+#define RK_ARENA_ATOMIC_INC(ptr) ((unsigned)InterlockedIncrement((volatile LONG *)(ptr)) - 1)
+#define RK_ARENA_ATOMIC_ADD(ptr, v) InterlockedExchangeAdd64((volatile LONG64 *)(ptr), (LONG64)(v))
+#define RK_ARENA_ATOMIC_SUB(ptr, v) InterlockedExchangeAdd64((volatile LONG64 *)(ptr), -(LONG64)(v))
+#define RK_ARENA_ATOMIC_LOAD(ptr) (*(volatile size_t *)(ptr))
+#define RK_ARENA_ATOMIC_LOAD_PTR(ptr) (*(void *volatile *)(ptr))
+#define RK_ARENA_ATOMIC_EXCHANGE(ptr, v) ((size_t)InterlockedExchange64((volatile LONG64 *)(ptr), (LONG64)(v)))
+#define RK_ARENA_ATOMIC_CAS(ptr, expected, v) ((size_t)InterlockedCompareExchange64((volatile LONG64 *)(ptr), (LONG64)(v), (LONG64)(expected)) == (size_t)(expected))
+#define RK_ARENA_SPIN_LOCK(ptr) while (InterlockedExchange((volatile LONG *)(ptr), 1)) YieldProcessor()
+#define RK_ARENA_SPIN_UNLOCK(ptr) InterlockedExchange((volatile LONG *)(ptr), 0)
+#define RK_ARENA_THREAD_LOCAL __declspec(thread)
+#else
+#define RK_ARENA_ATOMIC_INC(ptr) __atomic_fetch_add((ptr), 1, __ATOMIC_RELAXED)
+#define RK_ARENA_ATOMIC_ADD(ptr, v) __atomic_fetch_add((ptr), (v), __ATOMIC_RELAXED)
+#define RK_ARENA_ATOMIC_SUB(ptr, v) __atomic_fetch_sub((ptr), (v), __ATOMIC_RELAXED)
+#define RK_ARENA_ATOMIC_LOAD(ptr) __atomic_load_n((ptr), __ATOMIC_RELAXED)
+#define RK_ARENA_ATOMIC_LOAD_PTR(ptr) __atomic_load_n((ptr), __ATOMIC_RELAXED)
+#define RK_ARENA_ATOMIC_EXCHANGE(ptr, v) __atomic_exchange_n((ptr), (v), __ATOMIC_ACQ_REL)
+#define RK_ARENA_ATOMIC_CAS(ptr, expected, v) __atomic_compare_exchange_n((ptr), &(expected), (v), 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#define RK_ARENA_SPIN_LOCK(ptr) while (__atomic_exchange_n((ptr), 1, __ATOMIC_ACQUIRE)) \
+    while (__atomic_load_n((ptr), __ATOMIC_RELAXED))
+#define RK_ARENA_SPIN_UNLOCK(ptr) __atomic_store_n((ptr), 0, __ATOMIC_RELEASE)
+#define RK_ARENA_THREAD_LOCAL __thread
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define RK_ARENA_PREFETCHW(addr) __builtin_prefetch((addr), 1, 3)
+#elif defined(RK_ARENA_PLATFORM_WINDOWS)
+#define RK_ARENA_PREFETCHW(addr) PreFetchCacheLine(PF_TEMPORAL_LEVEL_1, (addr))
+#else
+#define RK_ARENA_PREFETCHW(addr) (void)(addr)
+#endif
+
 #if defined(RK_ARENA_DEBUG)
 #define RK_ARENA_ASSERT(expr, ...) if (!(expr))\
     rkArenaPanic("Assertion Failed ("#expr"): " __VA_ARGS__)
@@ -148,257 +869,3621 @@ void rkDebugArena(const rkArena *arena);
 // --- type definitions -------------------------------------------------------
 
 /**
- * This struct defines an allocation page in the arena
+ * This struct defines the descriptor of an allocation page. Descriptors live
+ * in the arena's page table, away from the memory regions they describe
  */
 typedef struct rkAllocPage
 {
-    uint8_t            *region; // The memory region of this page
-    size_t              offset; // The current offset into the memory region
-    size_t              size;   // The capacity of the memory region
-    struct rkAllocPage *next;   // A pointer to the next allocation page
+    uint8_t *region;      // The memory region of this page
+    size_t   offset;      // The current offset into the memory region
+    size_t   size;        // The capacity of the memory region
+    size_t   live;        // The number of allocations not yet released
+    uint8_t *base;        // The start of the mapping, in front of the color offset
+    size_t   mapped;      // The size of the mapping in bytes
+    size_t   next;        // The next page of the page cache or unused descriptor list
+    unsigned owner;       // The hint of the owning chain, or `RK_ARENA_PAGE_XXX`
+    unsigned kind;        // The `RK_ARENA_KIND_XXX` of the mapping
+    unsigned cold;        // The `RK_ARENA_COLD_XXX` state of the page
+    size_t   armedAt;     // When the page was made inaccessible, in milliseconds
+    uint8_t *packed;      // The compressed copy of the page, or `NULL`
+    size_t   packedSize;  // The size of the compressed copy
+    size_t   packedSpan;  // The number of bytes from `base` the compressed copy holds
+    size_t   lastUse;     // The arena clock when the page was last allocated from
+    size_t   lruPrev;     // The previous page in the spill queue
+    size_t   lruNext;     // The next page in the spill queue
+    size_t   spillOffset; // The offset of the page in the spill file
 } rkAllocPage;
 
+/**
+ * This struct defines a chain of allocation pages that serves one hint. Every
+ * page whose descriptor names the hint belongs to the chain
+ */
+typedef struct rkPageChain
+{
+    size_t curr;                      // The page allocations are bumped from, or `RK_ARENA_NO_PAGE`
+    size_t tails[RK_ARENA_MAX_TAILS]; // Retired pages sorted by free space, ascending
+    size_t numTails;                  // The number of retired pages with reusable tails
+} rkPageChain;
+
 /**
  * This struct defines the memory arena
  */
 typedef struct rkArena
 {
-    size_t       pageSize; // The capacity of the allocation pages
-    rkAllocPage *curr;     // The head of the allocation page linked list
-} rkArena;
+    size_t       pageSize;                    // The capacity of the allocation pages
+    unsigned     flags;                       // The `rkArenaFlags` the arena was created with
+    unsigned     color;                       // The cache color of the next new page
+    rkPageChain  chains[RK_ARENA_HINT_COUNT]; // The page chains of every hint
+    size_t       cache;                       // The first page retained after a reset for reuse
+    size_t       cachedBytes;                 // The total capacity of the cached pages
+    size_t       tailReused;                  // Bytes served from tails since the last reset
 
-// --- function prototypes ----------------------------------------------------
+    rkAllocPage *pages;      // The page table
+    size_t       numPages;   // The number of descriptors handed out so far
+    size_t       pagesCap;   // The capacity of the page table
+    size_t       unused;     // The first descriptor of an unmapped page
+    size_t      *index;      // Every mapped page, sorted by address
+    size_t       numIndexed; // The number of indexed pages
+    size_t       indexCap;   // The capacity of the index
 
-/**
- * Creates a new arena
+    rkArenaNumaPolicy numaPolicy;                         // The NUMA placement policy
+    unsigned long     numaMask[RK_ARENA_NUMA_MASK_WORDS]; // The nodes the policy applies to
+    int               numaNodes;                          // The online nodes when the policy was set
+
+    int frozen;    // Whether the pages in use are read-only
+    int mergeable; // Whether the frozen pages were offered to same-page merging
+
+    size_t clock;         // Ticks whenever a page is allocated from anew
+    size_t lruHead;       // The page in use allocated from least recently
+    size_t lruTail;       // The page in use allocated from most recently
+    size_t residentBytes; // The mapped size of the anonymous pages in use or cached
+    int    spillFd;       // The spill file, or `-1`
+    size_t spillBudget;   // The resident memory the arena may hold before spilling
+    size_t spillEnd;      // The end of the used part of the spill file
+    size_t numSpilled;    // The number of pages in the spill file
+
+    long   coldLock;      // Guards the tables and cold pages against the fault handler
+    size_t trimRequested; // Set by other threads to have the page cache released
+    size_t trimmedBytes;  // Bytes released on request, not yet reported
+
+    struct rkArena *poolNext; // The next idle arena in an arena pool shard
+} rkArena;
+
+
+/**
+ * This struct defines one independently locked free list of an arena pool
+ */
+typedef struct rkArenaPoolShard
+{
+    long     lock;  // The spin lock guarding the free list
+    rkArena *head;  // The head of the idle arena linked list
+    uint8_t  pad[RK_ARENA_CACHE_LINE - sizeof(long) - sizeof(rkArena *)];
+} rkArenaPoolShard;
+
+/**
+ * This struct defines the arena pool
+ */
+typedef struct rkArenaPool
+{
+    rkArenaPoolShard shards[RK_ARENA_POOL_SHARDS]; // The idle arenas
+    size_t           pageSize;                     // The page size of the arenas
+    unsigned         flags;                        // The `rkArenaFlags` of the arenas
+    size_t           shapePages;                   // The number of pages to shape arenas to
+    size_t           maxRetained;                  // The cap on retained bytes, or `0`
+    size_t           retained;                     // The page capacity held by idle arenas
+} rkArenaPool;
+
+// --- global state -----------------------------------------------------------
+
+// The sysfs node list the NUMA topology is read from
+static char rkNumaOnlinePath[4096] = RK_ARENA_NUMA_ONLINE_PATH;
+
+// Seeds the colors of new arenas so that they start at different cache sets
+static unsigned rkColorSeed = 0;
+
+// Hands out arena pool shards to threads in a round-robin fashion
+static unsigned rkShardSeed = 0;
+
+// The arena pool shard of the calling thread, plus one
+static RK_ARENA_THREAD_LOCAL unsigned rkThreadShard = 0;
+
+#if defined(RK_ARENA_PLATFORM_LINUX)
+// The arenas with `RK_ARENA_FLAG_COMPRESS`, whose pages the fault handler
+// decompresses, and the guard of their registration
+static rkArena *rkColdArenas[RK_ARENA_MAX_COLD_ARENAS];
+static long rkColdLock = 0;
+
+// The `SIGSEGV` action the fault handler passes foreign faults on to
+static int rkColdHandlerInstalled = 0;
+static struct sigaction rkPrevSegvAction;
+#endif /* RK_ARENA_PLATFORM_LINUX */
+
+// --- function prototypes ----------------------------------------------------
+
+/**
+ * Creates a new arena
  *
  * @param[in] pageSize
  *      The capacity of the allocation page memory regions
+ * @param[in] flags
+ *      A combination of `rkArenaFlags`
  *
  * @return
  *      A pointer to the newly created arena, or `NULL` upon failure
  */
-static rkArena *rkNewArena(size_t pageSize);
+static rkArena *rkNewArena(size_t pageSize, unsigned flags);
 
 /**
- * Creates a new allocation page
+ * Requests a new page from the OS, applies the arena's NUMA policy to it and
+ * records it in the page table and the page index
  *
+ * @param[in] arena
+ *      The arena to map the page for
  * @param[in] size
- *      The capacity of the allocation page
- * @param[in] next
- *      A pointer to the next allocation page in the linked list
+ *      The capacity of the page
+ * @param[in] owner
+ *      The hint of the chain the page goes to, or `RK_ARENA_PAGE_CACHED`
+ *
+ * @return
+ *      The descriptor of the page, or `RK_ARENA_NO_PAGE` upon failure
  */
-static rkAllocPage *rkNewPage(size_t size, rkAllocPage *next);
+static size_t rkMapPage(rkArena *arena, size_t size, unsigned owner);
 
 /**
- * Allocates `numBytes` bytes of memory from `page`
+ * Releases a page back to the OS and recycles its descriptor
+ *
+ * @param[in] arena
+ *      The arena the page belongs to
+ * @param[in] page
+ *      The descriptor of the page to release
+ */
+static void rkUnmapPage(rkArena *arena, size_t page);
+
+/**
+ * Stamps a page with the arena clock and appends it to the spill queue, which
+ * holds the anonymous pages in use ordered by their last use. Since the clock
+ * only moves forward, appending keeps the queue sorted
  *
+ * @param[in] arena
+ *      The arena the page belongs to
  * @param[in] page
- *      The allocation page to allocate the memory from
+ *      The descriptor of the page, which must not be queued yet
+ */
+static void rkQueuePage(rkArena *arena, size_t page);
+
+/**
+ * Removes a page from the spill queue
+ *
+ * @param[in] arena
+ *      The arena the page belongs to
+ * @param[in] page
+ *      The descriptor of the queued page
+ */
+static void rkUnqueuePage(rkArena *arena, size_t page);
+
+/**
+ * Marks a page as allocated from, moving it to the back of the spill queue
+ * if it is queued
+ *
+ * @param[in] arena
+ *      The arena the page belongs to
+ * @param[in] page
+ *      The descriptor of the page
+ */
+static void rkTouchPage(rkArena *arena, size_t page);
+
+/**
+ * Takes a page from the arena's page cache, or requests a new one from the OS
+ * if the cache is empty
+ *
+ * @param[in] arena
+ *      The arena to obtain the page for
+ * @param[in] owner
+ *      The hint of the chain the page goes to
+ *
+ * @return
+ *      The descriptor of the page, or `RK_ARENA_NO_PAGE` upon failure
+ */
+static size_t rkObtainPage(rkArena *arena, unsigned owner);
+
+/**
+ * Releases the page cache if another thread asked for it with
+ * `rkArenaRequestTrim`
+ *
+ * @param[in] arena
+ *      The arena owned by the calling thread
+ */
+static void rkHonourTrim(rkArena *arena);
+
+/**
+ * Makes room for `count` more pages in the page table and the page index, so
+ * that recording them cannot fail
+ *
+ * @param[in] arena
+ *      The arena whose tables to grow
+ * @param[in] count
+ *      The number of pages about to be recorded
+ *
+ * @return
+ *      `1` upon success, or `0` upon failure
+ */
+static int rkReservePages(rkArena *arena, size_t count);
+
+/**
+ * Moves a table into a new mapping with room for at least `needed` elements,
+ * doubling its capacity
+ *
+ * @param[in] table
+ *      The table to grow, or `NULL`
+ * @param[in,out] capacity
+ *      The capacity of the table in elements
+ * @param[in] elemSize
+ *      The size of an element in bytes
+ * @param[in] used
+ *      The number of elements to carry over
+ * @param[in] needed
+ *      The number of elements the table must be able to hold
+ *
+ * @return
+ *      The new table, or `NULL` upon failure, in which case `table` is kept
+ */
+static void *rkGrowTable(void *table, size_t *capacity, size_t elemSize, size_t used, size_t needed);
+
+/**
+ * Takes a descriptor from the unused list, or the next never used one. The
+ * page table must have room for it
+ *
+ * @param[in] arena
+ *      The arena to take the descriptor from
+ *
+ * @return
+ *      The descriptor
+ */
+static size_t rkNewDescriptor(rkArena *arena);
+
+/**
+ * Picks the color offset for the next new page of `arena`, rotating through
+ * the cache line offsets that fit in the slack of the page's mapping
+ *
+ * @param[in] arena
+ *      The arena the page belongs to
+ * @param[in] size
+ *      The capacity of the page
+ *
+ * @return
+ *      The offset of the memory region from the start of the mapping
+ */
+static size_t rkNextColor(rkArena *arena, size_t size);
+
+/**
+ * Gets the free space left at the end of a page
+ *
+ * @param[in] arena
+ *      The arena the page belongs to
+ * @param[in] page
+ *      The descriptor of the page
+ *
+ * @return
+ *      The number of free bytes
+ */
+static size_t rkPageFree(const rkArena *arena, size_t page);
+
+/**
+ * Gets the number of indexed pages whose memory region starts at or below
+ * `ptr`
+ *
+ * @param[in] arena
+ *      The arena to search
+ * @param[in] ptr
+ *      The address to search for
+ *
+ * @return
+ *      The position in the index right after the last such page
+ */
+static size_t rkIndexUpperBound(const rkArena *arena, const void *ptr);
+
+/**
+ * Inserts a page into the page index, which must have room for it
+ *
+ * @param[in] arena
+ *      The arena to index the page in
+ * @param[in] page
+ *      The descriptor of the page to index
+ */
+static void rkIndexPage(rkArena *arena, size_t page);
+
+/**
+ * Removes a page from the page index
+ *
+ * @param[in] arena
+ *      The arena the page is indexed in
+ * @param[in] page
+ *      The descriptor of the page to remove
+ */
+static void rkUnindexPage(rkArena *arena, size_t page);
+
+/**
+ * Looks up the page whose memory region contains `ptr`
+ *
+ * @param[in] arena
+ *      The arena to search
+ * @param[in] ptr
+ *      The pointer to look up
+ *
+ * @return
+ *      The descriptor of the page, or `RK_ARENA_NO_PAGE` if no page contains
+ *      `ptr`
+ */
+static size_t rkFindPage(const rkArena *arena, const void *ptr);
+
+/**
+ * Applies the arena's NUMA policy to a memory region. Failures are ignored,
+ * since the policy is merely a placement hint
+ *
+ * @param[in] arena
+ *      The arena whose policy to apply
+ * @param[in] ptr
+ *      The page aligned start of the region
  * @param[in] numBytes
- *      The number of bytes to allocate from the allocation page
+ *      The size of the region in bytes
+ * @param[in] flags
+ *      The `mbind` flags
+ */
+static void rkApplyNumaPolicy(const rkArena *arena, void *ptr, size_t numBytes, unsigned flags);
+
+/**
+ * Reads the online NUMA nodes from the topology file
+ *
+ * @param[out] mask
+ *      The node mask to populate, may be `NULL`
  *
  * @return
- *      A pointer to the newly allocated memory, or `NULL` upon failure
+ *      The number of online nodes, which is at least `1`
  */
-static void *rkAllocFromPage(rkAllocPage *page, size_t numBytes);
+static int rkReadNumaNodes(unsigned long *mask);
+
+/**
+ * Applies the arena's fork flags to a memory region, so that `fork` neither
+ * copies its page tables nor leaves it copy-on-write in the parent. Kernels
+ * without `MADV_WIPEONFORK` get `MADV_DONTFORK` instead
+ *
+ * @param[in] arena
+ *      The arena whose flags to apply
+ * @param[in] ptr
+ *      The page aligned start of the region
+ * @param[in] numBytes
+ *      The size of the region in bytes
+ */
+static void rkApplyForkPolicy(const rkArena *arena, void *ptr, size_t numBytes);
+
+/**
+ * Changes the protection of the mapping of a page
+ *
+ * @param[in] page
+ *      The page to protect
+ * @param[in] writable
+ *      Whether the page is writable or read-only
+ *
+ * @return
+ *      `1` upon success, or `0` upon failure
+ */
+static int rkProtectPage(const rkAllocPage *page, int writable);
+
+/**
+ * Reads a single counter from a sysfs or procfs file
+ *
+ * @param[in] path
+ *      The path of the file
+ *
+ * @return
+ *      The counter, or `-1` if it could not be read
+ */
+static long rkReadCounter(const char *path);
+
+/**
+ * Records an arena with `RK_ARENA_FLAG_COMPRESS` for the fault handler, and
+ * installs the handler on first use
+ *
+ * @param[in] arena
+ *      The arena to record
+ *
+ * @return
+ *      `1` upon success, or `0` if there is no room or the handler could not
+ *      be installed
+ */
+static int rkRegisterColdArena(rkArena *arena);
+
+/**
+ * Removes an arena from the fault handler's records
+ *
+ * @param[in] arena
+ *      The arena to remove
+ */
+static void rkUnregisterColdArena(rkArena *arena);
+
+#if defined(RK_ARENA_PLATFORM_LINUX)
+/**
+ * Handles faults on inaccessible pages by making them accessible again, and
+ * decompressing them if need be. Faults on other memory are passed on to the
+ * previous `SIGSEGV` action
+ *
+ * @param[in] sig
+ *      The signal number
+ * @param[in] info
+ *      The fault details
+ * @param[in] context
+ *      The interrupted context
+ */
+static void rkColdFaultHandler(int sig, siginfo_t *info, void *context);
+#endif /* RK_ARENA_PLATFORM_LINUX */
+
+/**
+ * Takes the lock that keeps the fault handler out of the page table, the
+ * page index and the cold states while they change. Arenas without
+ * `RK_ARENA_FLAG_COMPRESS` have no fault handler to keep out, so this does
+ * nothing for them
+ *
+ * @param[in] arena
+ *      The arena to lock
+ */
+static void rkLockTables(rkArena *arena);
+
+/**
+ * Releases the lock taken by `rkLockTables`
+ *
+ * @param[in] arena
+ *      The arena to unlock
+ */
+static void rkUnlockTables(rkArena *arena);
+
+/**
+ * Makes an inaccessible page accessible again and restores its contents if
+ * it was compressed. The contents are restored into a staging mapping that
+ * replaces the page in one step, so that other threads keep faulting until
+ * the page is complete. The compressed copy is kept for `rkDropPacked`, so
+ * that this function is safe to call from the fault handler. The table lock
+ * has to be held
+ *
+ * @param[in] arena
+ *      The arena the page belongs to
+ * @param[in] page
+ *      The descriptor of the page
+ */
+static void rkWarmPage(rkArena *arena, size_t page);
+
+/**
+ * Frees the stale compressed copy of an accessible page. The table lock has
+ * to be held
+ *
+ * @param[in] arena
+ *      The arena the page belongs to
+ * @param[in] page
+ *      The descriptor of the page
+ */
+static void rkDropPacked(rkArena *arena, size_t page);
+
+/**
+ * Makes a page accessible from the owning thread, restoring its contents and
+ * freeing the compressed copy
+ *
+ * @param[in] arena
+ *      The arena the page belongs to
+ * @param[in] page
+ *      The descriptor of the page
+ */
+static void rkHeatPage(rkArena *arena, size_t page);
+
+/**
+ * Makes every page overlapping a range accessible, e.g. before the kernel
+ * reads or writes it
+ *
+ * @param[in] arena
+ *      The arena the range was allocated in
+ * @param[in] ptr
+ *      The start of the range
+ * @param[in] numBytes
+ *      The size of the range in bytes
+ */
+static void rkWarmRange(rkArena *arena, const void *ptr, size_t numBytes);
+
+/**
+ * Makes every page of an arena accessible and frees the compressed copies
+ *
+ * @param[in] arena
+ *      The arena to warm up
+ */
+static void rkWarmArena(rkArena *arena);
+
+/**
+ * Makes a page accessible without restoring its contents, which are dead
+ *
+ * @param[in] arena
+ *      The arena the page belongs to
+ * @param[in] page
+ *      The descriptor of the page
+ */
+static void rkDiscardCold(rkArena *arena, size_t page);
+
+/**
+ * Compresses an inaccessible page and releases its memory to the OS. Pages
+ * that do not compress to at most three quarters of their size are made
+ * accessible again instead. The table lock has to be held
+ *
+ * @param[in] arena
+ *      The arena the page belongs to
+ * @param[in] page
+ *      The descriptor of the page
+ *
+ * @return
+ *      The number of bytes released
+ */
+static size_t rkPackPage(rkArena *arena, size_t page);
+
+/**
+ * Compresses `n` bytes with the in-tree LZ codec
+ *
+ * @param[in] src
+ *      The bytes to compress
+ * @param[in] n
+ *      The number of bytes to compress
+ * @param[out] dst
+ *      The buffer to write the compressed bytes to
+ * @param[in] capacity
+ *      The capacity of `dst`
+ *
+ * @return
+ *      The size of the compressed bytes, or `0` if they do not fit in `dst`
+ */
+static size_t rkLzCompress(const uint8_t *src, size_t n, uint8_t *dst, size_t capacity);
+
+/**
+ * Appends one sequence of literals and a back reference to the output of the
+ * LZ codec
+ *
+ * @param[out] dst
+ *      The output buffer
+ * @param[in] capacity
+ *      The capacity of `dst`
+ * @param[in,out] out
+ *      The size of the output so far
+ * @param[in] literals
+ *      The literals to copy
+ * @param[in] numLiterals
+ *      The number of literals
+ * @param[in] offset
+ *      The distance of the match
+ * @param[in] matchLength
+ *      The length of the match, or `0` for the final sequence
+ *
+ * @return
+ *      `1` upon success, or `0` if the sequence does not fit in `dst`
+ */
+static int rkLzEmit(uint8_t *dst, size_t capacity, size_t *out, const uint8_t *literals, size_t numLiterals, size_t offset, size_t matchLength);
+
+/**
+ * Decompresses the output of `rkLzCompress`. This function is safe to call
+ * from a signal handler
+ *
+ * @param[in] src
+ *      The compressed bytes
+ * @param[in] n
+ *      The number of compressed bytes
+ * @param[out] dst
+ *      The buffer to restore the bytes into
+ * @param[in] size
+ *      The number of bytes to restore
+ *
+ * @return
+ *      `1` upon success, or `0` if the compressed bytes are corrupt
+ */
+static int rkLzDecompress(const uint8_t *src, size_t n, uint8_t *dst, size_t size);
+
+/**
+ * Brings the resident memory of an arena with a spill file back within its
+ * budget, by trimming the page cache and then spilling pages from the front
+ * of the spill queue. Current pages and the page mapped last stay resident,
+ * and cold pages are warmed up before they are spilled
+ *
+ * @param[in] arena
+ *      The arena to bring within budget
+ */
+static void rkEnforceBudget(rkArena *arena);
+
+/**
+ * Writes a page to the end of the spill file and maps the file over it in
+ * place. Pages of compressed arenas stay read-only from the write until the
+ * file replaces them, so that writes from other threads are not lost
+ *
+ * @param[in] arena
+ *      The arena the page belongs to
+ * @param[in] page
+ *      The descriptor of the page
+ *
+ * @return
+ *      `1` upon success, or `0` if the page could not be written or mapped,
+ *      in which case it stays resident
+ */
+static int rkSpillPage(rkArena *arena, size_t page);
+
+/**
+ * Releases the file space of a spilled page that was unmapped, and truncates
+ * the spill file once it holds no more pages
+ *
+ * @param[in] arena
+ *      The arena the page belonged to
+ * @param[in] page
+ *      The unmapped page
+ */
+static void rkReleaseSpill(rkArena *arena, const rkAllocPage *page);
+
+/**
+ * Allocates `numBytes` bytes of memory from `page`
+ *
+ * @param[in] page
+ *      The allocation page to allocate the memory from
+ * @param[in] numBytes
+ *      The number of bytes to allocate from the allocation page
+ *
+ * @return
+ *      A pointer to the newly allocated memory, or `NULL` upon failure
+ */
+static void *rkAllocFromPage(rkAllocPage *page, size_t numBytes);
+
+/**
+ * Prefetches the cache lines just past the bump pointer of `page` for
+ * writing, and touches the next OS page if the allocation at `ptr` moved the
+ * bump pointer past the touch threshold of its OS page
+ *
+ * @param[in] page
+ *      The allocation page that was just allocated from
+ * @param[in] ptr
+ *      A pointer to the start of the allocation
+ */
+static void rkPrefetchAhead(const rkAllocPage *page, const uint8_t *ptr);
+
+/**
+ * Allocates `numBytes` bytes from the tail of the retired page with the
+ * smallest free space that still fits the request
+ *
+ * @param[in] arena
+ *      The arena to allocate from
+ * @param[in] chain
+ *      The page chain whose tails to allocate from
+ * @param[in] numBytes
+ *      The number of bytes to allocate
+ *
+ * @return
+ *      A pointer to the allocated memory, or `NULL` if no tail fits
+ */
+static void *rkAllocFromTails(rkArena *arena, rkPageChain *chain, size_t numBytes);
+
+/**
+ * Allocates `numBytes` bytes from a dedicated page of the chain of `hint`,
+ * leaving the chain's current page as it is
+ *
+ * @param[in] arena
+ *      The arena to allocate from
+ * @param[in] hint
+ *      The hint of the chain the dedicated page belongs to
+ * @param[in] numBytes
+ *      The number of bytes to allocate, more than the arena's page size
+ *
+ * @return
+ *      A pointer to the allocated memory, or `NULL` upon failure
+ */
+static void *rkAllocLarge(rkArena *arena, rkArenaHint hint, size_t numBytes);
+
+/**
+ * Reads or receives up to `maxBytes` bytes into the free space of the current
+ * `RK_NORMAL` page, or into a dedicated page if they do not fit in a page
+ *
+ * @param[in] arena
+ *      The arena to read into
+ * @param[in] fd
+ *      The file descriptor or socket to read from
+ * @param[in] maxBytes
+ *      The maximum number of bytes to read
+ * @param[in] recvFlags
+ *      The `recv` flags, or `-1` to `read` instead
+ * @param[out] numRead
+ *      The number of bytes read
+ *
+ * @return
+ *      A pointer to the bytes read, or `NULL` upon failure
+ */
+static void *rkIngest(rkArena *arena, int fd, size_t maxBytes, int recvFlags, size_t *numRead);
+
+/**
+ * Offers a retired page to the best-fit tail list. Pages with too little
+ * free space, or less than every listed page when the list is full, are not
+ * kept and their free space is wasted
+ *
+ * @param[in] arena
+ *      The arena the page belongs to
+ * @param[in] chain
+ *      The page chain the page belongs to
+ * @param[in] page
+ *      The descriptor of the page that is no longer the current page
+ */
+static void rkRetirePage(rkArena *arena, rkPageChain *chain, size_t page);
+
+/**
+ * Grows the dedicated large page that starts at `ptr` to `newSize` bytes by
+ * remapping it, which moves page table entries instead of bytes. Other pages
+ * are spilled if the growth takes the arena over its spill budget
+ *
+ * @param[in] arena
+ *      The arena the allocation was made in
+ * @param[in] ptr
+ *      A pointer to the start of the allocation
+ * @param[in] newSize
+ *      The new size of the allocation in bytes
+ *
+ * @return
+ *      A pointer to the grown allocation, or `NULL` if `ptr` is not a large
+ *      allocation, remapping is unsupported or it failed
+ */
+static void *rkRemapLarge(rkArena *arena, void *ptr, size_t newSize);
+
+/**
+ * Takes a page whose allocations were all released out of its chain. The
+ * current page is rewound in place, every other page is cached, or released
+ * if it is a dedicated large page
+ *
+ * @param[in] arena
+ *      The arena the page belongs to
+ * @param[in] page
+ *      The descriptor of the page without live allocations
+ */
+static void rkEmptyPage(rkArena *arena, size_t page);
+
+/**
+ * Moves every page of the chains of hints `first` up to `last` but their
+ * current ones into the page cache in a single pass over the page table, and
+ * rewinds the current pages. Dedicated large pages are released instead
+ *
+ * @param[in] arena
+ *      The arena the chains belong to
+ * @param[in] first
+ *      The first hint to reset
+ * @param[in] last
+ *      One past the last hint to reset
+ */
+static void rkResetChains(rkArena *arena, unsigned first, unsigned last);
+
+/**
+ * Maps and faults in pages until the arena owns `numPages` pages, including
+ * its current one
+ *
+ * @param[in] arena
+ *      The arena to warm up
+ * @param[in] numPages
+ *      The number of pages the arena should own
+ */
+static void rkPrewarmArena(rkArena *arena, size_t numPages);
+
+/**
+ * Gets the page capacity owned by a freshly reset arena
+ *
+ * @param[in] arena
+ *      The arena
+ *
+ * @return
+ *      The capacity of the current pages and the page cache in bytes
+ */
+static size_t rkArenaFootprint(const rkArena *arena);
+
+/**
+ * Gets the arena pool shard of the calling thread
+ *
+ * @return
+ *      The index of the shard
+ */
+static size_t rkPoolShardIndex(void);
+
+/**
+ * An operating system agnostic memory request function. This simply performs
+ * a syscall to request memory from the kernel
+ *
+ * @param[in] numBytes
+ *      The number of bytes to allocate
+ *
+ * @return
+ *      A pointer to the newly allocated memory, or `NULL` upon failure
+ */
+static void *rkOsMalloc(size_t numBytes);
+
+/**
+ * Frees the memory allocated at `ptr` by use of an operating system syscall
+ *
+ * @param[in] ptr
+ *      A pointer to the memory to deallocate
+ * @param[in] numBytes
+ *      The number of bytes to deallocate
+ */
+static void rkOsFree(void *ptr, size_t numBytes);
+
+#if defined(RK_ARENA_DEBUG)
+/**
+ * This is just a show stopper for is something horribly goes wrong
+ */
+static void rkArenaPanic(const char *fmt, ...);
+#endif
+
+
+// --- arena interface --------------------------------------------------------
+
+rkArena *rkCreateArena(void)
+{
+    return rkNewArena(DEFAULT_PAGE_SIZE, RK_ARENA_FLAG_NONE);
+}
+
+rkArena *rkCreateArenaWithPageSize(size_t pageSize)
+{
+    return rkNewArena(pageSize, RK_ARENA_FLAG_NONE);
+}
+
+rkArena *rkCreateArenaWithFlags(size_t pageSize, unsigned flags)
+{
+    return rkNewArena(pageSize, flags);
+}
+
+void rkFreeArena(rkArena *arena)
+{
+    RK_ARENA_ASSERT(arena != NULL, "Cannot free a NULL arena");
+
+    if (arena->flags & RK_ARENA_FLAG_COMPRESS)
+    {
+        rkUnregisterColdArena(arena);
+        for (size_t i = 0; i < arena->numPages; i++)
+        {
+            free(arena->pages[i].packed);
+        }
+    }
+
+#if defined(RK_ARENA_PLATFORM_LINUX)
+    // The index is sorted by address, so mappings that happen to be
+    // neighbours are released with a single call
+    uint8_t *runBase = NULL;
+    size_t runBytes = 0;
+    for (size_t i = 0; i < arena->numIndexed; i++)
+    {
+        const rkAllocPage *const page = &arena->pages[arena->index[i]];
+        if (runBase && runBase + runBytes == page->base)
+        {
+            runBytes += page->mapped;
+            continue;
+        }
+
+        if (runBase)
+        {
+            rkOsFree(runBase, runBytes);
+        }
+
+        runBase = page->base;
+        runBytes = page->mapped;
+    }
+
+    if (runBase)
+    {
+        rkOsFree(runBase, runBytes);
+    }
+#else
+    for (size_t i = 0; i < arena->numIndexed; i++)
+    {
+        const rkAllocPage *const page = &arena->pages[arena->index[i]];
+        rkOsFree(page->base, page->mapped);
+    }
+#endif /* RK_ARENA_PLATFORM_LINUX */
+
+#if defined(RK_ARENA_PLATFORM_LINUX)
+    if (arena->spillFd >= 0)
+    {
+        close(arena->spillFd);
+    }
+#endif /* RK_ARENA_PLATFORM_LINUX */
+
+    if (arena->pages)
+    {
+        rkOsFree(arena->pages, arena->pagesCap * sizeof(rkAllocPage));
+    }
+
+    if (arena->index)
+    {
+        rkOsFree(arena->index, arena->indexCap * sizeof(size_t));
+    }
+
+    rkOsFree(arena, sizeof(rkArena));
+}
+
+void rkResetArena(rkArena *arena)
+{
+    RK_ARENA_ASSERT(arena != NULL, "Cannot reset a NULL arena");
+
+    rkArenaThaw(arena);
+    rkResetChains(arena, 0, RK_ARENA_HINT_COUNT);
+    arena->tailReused = 0;
+    rkHonourTrim(arena);
+}
+
+void rkResetArenaHint(rkArena *arena, rkArenaHint hint)
+{
+    RK_ARENA_ASSERT(arena != NULL, "Cannot reset a NULL arena");
+    RK_ARENA_ASSERT(hint < RK_ARENA_HINT_COUNT, "Invalid hint: %d", (int)hint);
+
+    rkArenaThaw(arena);
+    rkResetChains(arena, (unsigned)hint, (unsigned)hint + 1);
+    rkHonourTrim(arena);
+}
+
+size_t rkArenaTrim(rkArena *arena, size_t keepBytes)
+{
+    RK_ARENA_ASSERT(arena != NULL, "Cannot trim a NULL arena");
+
+    size_t released = 0;
+    while (arena->cache != RK_ARENA_NO_PAGE && arena->cachedBytes > keepBytes)
+    {
+        const size_t page = arena->cache;
+        const size_t size = arena->pages[page].size;
+
+        arena->cache = arena->pages[page].next;
+        arena->cachedBytes -= size;
+        released += size;
+        rkUnmapPage(arena, page);
+    }
+
+    return released;
+}
+
+size_t rkArenaRequestTrim(rkArena *arena)
+{
+    RK_ARENA_ASSERT(arena != NULL, "Cannot trim a NULL arena");
+
+    RK_ARENA_ATOMIC_EXCHANGE(&arena->trimRequested, 1);
+    return RK_ARENA_ATOMIC_EXCHANGE(&arena->trimmedBytes, 0);
+}
+
+void *rkArenaAlloc(rkArena *arena, size_t numBytes)
+{
+    return rkArenaAllocHint(arena, numBytes, RK_NORMAL);
+}
+
+void *rkArenaAllocHint(rkArena *arena, size_t numBytes, rkArenaHint hint)
+{
+    RK_ARENA_ASSERT(arena != NULL, "Cannot allocate from NULL arena");
+    RK_ARENA_ASSERT(hint < RK_ARENA_HINT_COUNT, "Invalid hint: %d", (int)hint);
+    if (arena->frozen)
+    {
+        return NULL;
+    }
+
+    if (arena->flags & RK_ARENA_FLAG_DIRECT_IO)
+    {
+        if (numBytes > SIZE_MAX - RK_ARENA_DIRECT_BLOCK)
+        {
+            return NULL;
+        }
+
+        numBytes = (numBytes + RK_ARENA_DIRECT_BLOCK - 1) & ~(size_t)(RK_ARENA_DIRECT_BLOCK - 1);
+    }
+
+    if (numBytes > arena->pageSize)
+    {
+        return rkAllocLarge(arena, hint, numBytes);
+    }
+
+    rkPageChain *const chain = &arena->chains[hint];
+    const int fits = chain->curr != RK_ARENA_NO_PAGE && rkPageFree(arena, chain->curr) >= numBytes;
+    if (chain->numTails > 0 && (numBytes <= RK_ARENA_SMALL_ALLOC(arena->pageSize) || !fits))
+    {
+        void *const ptr = rkAllocFromTails(arena, chain, numBytes);
+        if (ptr)
+        {
+            return ptr;
+        }
+    }
+
+    if (!fits)
+    {
+        const size_t newPage = rkObtainPage(arena, (unsigned)hint);
+        if (newPage == RK_ARENA_NO_PAGE)
+        {
+            return NULL;
+        }
+
+        if (chain->curr != RK_ARENA_NO_PAGE)
+        {
+            rkRetirePage(arena, chain, chain->curr);
+        }
+
+        chain->curr = newPage;
+    }
+
+    rkAllocPage *const page = &arena->pages[chain->curr];
+    void *const ptr = rkAllocFromPage(page, numBytes);
+    if (arena->flags & RK_ARENA_FLAG_PREFETCH)
+    {
+        rkPrefetchAhead(page, (const uint8_t *)ptr);
+    }
+
+    return ptr;
+}
+
+void *rkArenaAllocZeroed(rkArena *arena, size_t numBytes)
+{
+    RK_ARENA_ASSERT(arena != NULL, "Cannot allocate from NULL arena");
+
+    void *const ptr = rkArenaAlloc(arena, numBytes);
+    if (!ptr)
+    {
+        return NULL;
+    }
+
+    memset(ptr, 0x00, numBytes);
+    return ptr;
+}
+
+int rkArenaReserveSlices(rkArena *arena, const size_t *counts, size_t n, size_t elemSize, void **out)
+{
+    RK_ARENA_ASSERT(arena != NULL, "Cannot allocate from NULL arena");
+    RK_ARENA_ASSERT(n == 0 || (counts != NULL && out != NULL), "Cannot reserve slices without counts or output");
+
+    size_t total = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (counts[i] > (SIZE_MAX - total) / (elemSize ? elemSize : 1))
+        {
+            return 0;
+        }
+
+        total += counts[i] * elemSize;
+    }
+
+    if (total == 0)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            out[i] = NULL;
+        }
+
+        return 1;
+    }
+
+    uint8_t *const base = (uint8_t *)rkArenaAlloc(arena, total);
+    if (!base)
+    {
+        return 0;
+    }
+
+    size_t offset = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = (void *)(base + offset);
+        offset += counts[i] * elemSize;
+    }
+
+    return 1;
+}
+
+int rkArenaAbsorb(rkArena *dst, rkArena *src)
+{
+    RK_ARENA_ASSERT(dst != NULL, "Cannot absorb into a NULL arena");
+    RK_ARENA_ASSERT(src != NULL, "Cannot absorb a NULL arena");
+    RK_ARENA_ASSERT(dst != src, "Cannot absorb an arena into itself");
+    if (dst->frozen || src->frozen || src->numSpilled > 0)
+    {
+        return 0;
+    }
+
+    // Regular pages of another size would count as large pages of `dst`, and
+    // the flags decide the alignment and lifetime of every allocation
+    const unsigned mustMatch = RK_ARENA_FLAG_DIRECT_IO | RK_ARENA_FLAG_REFCOUNT;
+    if (dst->pageSize != src->pageSize || ((dst->flags ^ src->flags) & mustMatch))
+    {
+        return 0;
+    }
+
+    // The pages may move to an arena the fault handler does not know about
+    rkWarmArena(src);
+
+    size_t numPages = 0;
+    for (size_t i = 0; i < src->numPages; i++)
+    {
+        numPages += src->pages[i].owner < RK_ARENA_HINT_COUNT;
+    }
+
+    if (!rkReservePages(dst, numPages))
+    {
+        return 0;
+    }
+
+    // The descriptors are appended to the page table of `dst` as one block,
+    // and the current pages and tails of `src` are translated on the way.
+    // Until the indexes are merged, `next` of a moved page holds its new
+    // descriptor
+    rkPageChain moved[RK_ARENA_HINT_COUNT];
+    memcpy(moved, src->chains, sizeof(moved));
+    for (size_t i = 0; i < src->numPages; i++)
+    {
+        rkAllocPage *const page = &src->pages[i];
+        if (page->owner >= RK_ARENA_HINT_COUNT)
+        {
+            continue;
+        }
+
+        const size_t j = dst->numPages++;
+        dst->pages[j] = *page;
+        dst->pages[j].next = RK_ARENA_NO_PAGE;
+        page->next = j;
+        if (page->kind == RK_ARENA_KIND_ANON)
+        {
+            src->residentBytes -= page->mapped;
+            dst->residentBytes += page->mapped;
+        }
+
+        rkPageChain *const chain = &moved[page->owner];
+        if (src->chains[page->owner].curr == i)
+        {
+            chain->curr = j;
+        }
+
+        for (size_t t = 0; t < chain->numTails; t++)
+        {
+            if (src->chains[page->owner].tails[t] == i)
+            {
+                chain->tails[t] = j;
+            }
+        }
+    }
+
+    // The spill queue of `src` holds only pages in use, so all of it moves
+    // to the back of the queue of `dst`, in order
+    for (size_t i = src->lruHead; i != RK_ARENA_NO_PAGE; i = src->pages[i].lruNext)
+    {
+        rkQueuePage(dst, src->pages[i].next);
+    }
+    src->lruHead = RK_ARENA_NO_PAGE;
+    src->lruTail = RK_ARENA_NO_PAGE;
+
+    // Both indexes are sorted by address, so they are merged from the back
+    // into the room reserved at the end of the index of `dst`
+    rkLockTables(dst);
+    size_t a = dst->numIndexed;
+    size_t b = src->numIndexed;
+    size_t out = dst->numIndexed + numPages;
+    while (b > 0)
+    {
+        const rkAllocPage *const from = &src->pages[src->index[b - 1]];
+        if (from->owner >= RK_ARENA_HINT_COUNT)
+        {
+            b--;
+            continue;
+        }
+
+        if (a > 0 && dst->pages[dst->index[a - 1]].region > from->region)
+        {
+            dst->index[--out] = dst->index[--a];
+            continue;
+        }
+
+        dst->index[--out] = from->next;
+        b--;
+    }
+    dst->numIndexed += numPages;
+    rkUnlockTables(dst);
+
+    // Only the cached pages remain in the index of `src`
+    rkLockTables(src);
+    size_t kept = 0;
+    for (size_t k = 0; k < src->numIndexed; k++)
+    {
+        const size_t i = src->index[k];
+        if (src->pages[i].owner >= RK_ARENA_HINT_COUNT)
+        {
+            src->index[kept++] = i;
+        }
+    }
+    src->numIndexed = kept;
+    rkUnlockTables(src);
+
+    for (size_t i = 0; i < src->numPages; i++)
+    {
+        rkAllocPage *const page = &src->pages[i];
+        if (page->owner < RK_ARENA_HINT_COUNT)
+        {
+            page->owner = RK_ARENA_PAGE_UNUSED;
+            page->next = src->unused;
+            src->unused = i;
+        }
+    }
+
+    for (size_t h = 0; h < RK_ARENA_HINT_COUNT; h++)
+    {
+        rkPageChain *const to = &dst->chains[h];
+        const rkPageChain *const from = &moved[h];
+        if (to->curr == RK_ARENA_NO_PAGE)
+        {
+            to->curr = from->curr;
+        }
+        else if (from->curr != RK_ARENA_NO_PAGE)
+        {
+            rkRetirePage(dst, to, from->curr);
+        }
+
+        for (size_t t = 0; t < from->numTails; t++)
+        {
+            rkRetirePage(dst, to, from->tails[t]);
+        }
+
+        src->chains[h].curr = RK_ARENA_NO_PAGE;
+        src->chains[h].numTails = 0;
+    }
+
+    dst->tailReused += src->tailReused;
+    src->tailReused = 0;
+
+    return 1;
+}
+
+int rkArenaOwns(const rkArena *arena, const void *ptr)
+{
+    RK_ARENA_ASSERT(arena != NULL, "Cannot query a NULL arena");
+
+    const size_t i = rkFindPage(arena, ptr);
+    if (i == RK_ARENA_NO_PAGE)
+    {
+        return 0;
+    }
+
+    const rkAllocPage *const page = &arena->pages[i];
+    return page->owner < RK_ARENA_HINT_COUNT && (const uint8_t *)ptr < page->region + page->offset;
+}
+
+void rkArenaRelease(rkArena *arena, void *ptr)
+{
+    RK_ARENA_ASSERT(arena != NULL, "Cannot release from a NULL arena");
+    RK_ARENA_ASSERT(arena->flags & RK_ARENA_FLAG_REFCOUNT, "Cannot release allocations without RK_ARENA_FLAG_REFCOUNT");
+    if (!ptr)
+    {
+        return;
+    }
+
+    const size_t i = rkFindPage(arena, ptr);
+    RK_ARENA_ASSERT(i != RK_ARENA_NO_PAGE, "Pointer does not belong to the arena: %p", ptr);
+
+    rkAllocPage *const page = &arena->pages[i];
+    RK_ARENA_ASSERT(page->owner < RK_ARENA_HINT_COUNT && (uint8_t *)ptr < page->region + page->offset, "Pointer does not belong to a page in use: %p", ptr);
+    RK_ARENA_ASSERT(page->live > 0, "Released more allocations than were made: %p", ptr);
+    if (--page->live == 0)
+    {
+        rkEmptyPage(arena, i);
+    }
+}
+
+void *rkArenaRealloc(rkArena *arena, void *ptr, size_t oldSize, size_t newSize)
+{
+    RK_ARENA_ASSERT(arena != NULL, "Cannot reallocate from NULL arena");
+    RK_ARENA_ASSERT(ptr != NULL, "Cannot reallocate a NULL pointer");
+    RK_ARENA_ASSERT(oldSize <= newSize, "oldSize cannot be greater than newSize");
+    if (arena->frozen)
+    {
+        return NULL;
+    }
+
+    if ((arena->flags & RK_ARENA_FLAG_DIRECT_IO) && newSize <= SIZE_MAX - RK_ARENA_DIRECT_BLOCK)
+    {
+        newSize = (newSize + RK_ARENA_DIRECT_BLOCK - 1) & ~(size_t)(RK_ARENA_DIRECT_BLOCK - 1);
+    }
+
+    if (newSize > arena->pageSize)
+    {
+        void *const remapped = rkRemapLarge(arena, ptr, newSize);
+        if (remapped)
+        {
+            return remapped;
+        }
+    }
+
+    uint8_t *const newBytes = (uint8_t *)rkArenaAlloc(arena, newSize);
+    if (!newBytes)
+    {
+        return NULL;
+    }
+
+    memcpy(newBytes, ptr, oldSize);
+    if (arena->flags & RK_ARENA_FLAG_REFCOUNT)
+    {
+        rkArenaRelease(arena, ptr);
+    }
+
+    return (void *)newBytes;
+}
+
+void *rkArenaReadFile(rkArena *arena, const char *path, size_t *size)
+{
+    RK_ARENA_ASSERT(arena != NULL, "Cannot read into a NULL arena");
+    RK_ARENA_ASSERT(path != NULL, "Cannot read a NULL path");
+
+#if defined(RK_ARENA_PLATFORM_LINUX)
+    int direct = (arena->flags & RK_ARENA_FLAG_DIRECT_IO) && RK_ARENA_O_DIRECT != 0;
+    int fd = open(path, O_RDONLY | O_CLOEXEC | (direct ? RK_ARENA_O_DIRECT : 0));
+    if (fd < 0 && direct && errno == EINVAL)
+    {
+        // Some file systems, tmpfs among them, refuse direct I/O
+        direct = 0;
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+    }
+
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    // One block past the file size leaves room to read up to the end of file
+    size_t capacity = ((size_t)st.st_size / RK_ARENA_DIRECT_BLOCK + 1) * RK_ARENA_DIRECT_BLOCK;
+    uint8_t *buffer = (uint8_t *)rkArenaAlloc(arena, capacity);
+    size_t total = 0;
+    while (buffer)
+    {
+        if (total == capacity)
+        {
+            // The file grew while it was read
+            if (capacity > SIZE_MAX / 2)
+            {
+                buffer = NULL;
+                break;
+            }
+
+            buffer = (uint8_t *)rkArenaRealloc(arena, buffer, total, capacity * 2);
+            capacity *= 2;
+            continue;
+        }
+
+        const size_t chunk = capacity - total < RK_ARENA_DIRECT_CHUNK ? capacity - total : RK_ARENA_DIRECT_CHUNK;
+        rkWarmRange(arena, buffer + total, chunk);
+        const ssize_t n = read(fd, buffer + total, chunk);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (n < 0)
+        {
+            buffer = NULL;
+            break;
+        }
+
+        if (n == 0)
+        {
+            break;
+        }
+
+        total += (size_t)n;
+        if (direct && total % RK_ARENA_DIRECT_BLOCK != 0)
+        {
+            // Direct reads only come up short at the end of the file, and
+            // reading on into an unaligned buffer would fail
+            break;
+        }
+    }
+
+    close(fd);
+#else
+    FILE *const file = fopen(path, "rb");
+    if (!file)
+    {
+        return NULL;
+    }
+
+    long length = -1;
+    if (fseek(file, 0, SEEK_END) == 0)
+    {
+        length = ftell(file);
+        rewind(file);
+    }
+
+    uint8_t *buffer = NULL;
+    size_t total = 0;
+    if (length >= 0)
+    {
+        buffer = (uint8_t *)rkArenaAlloc(arena, (size_t)length + 1);
+    }
+
+    if (buffer)
+    {
+        total = fread(buffer, 1, (size_t)length, file);
+        if (ferror(file))
+        {
+            buffer = NULL;
+        }
+    }
+
+    fclose(file);
+#endif /* RK_ARENA_PLATFORM_LINUX */
+
+    if (buffer && size)
+    {
+        *size = total;
+    }
+
+    return (void *)buffer;
+}
+
+const void *rkArenaMapFile(rkArena *arena, const char *path, size_t *size)
+{
+    RK_ARENA_ASSERT(arena != NULL, "Cannot map into a NULL arena");
+    RK_ARENA_ASSERT(path != NULL, "Cannot map a NULL path");
+
+#if defined(RK_ARENA_PLATFORM_LINUX)
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0 || !rkReservePages(arena, 1))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    const size_t length = (size_t)st.st_size;
+    void *const base = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    madvise(base, length, MADV_SEQUENTIAL);
+
+    // The mapping joins the chain as a full page with a single allocation
+    const size_t i = rkNewDescriptor(arena);
+    rkAllocPage *const page = &arena->pages[i];
+    page->region = (uint8_t *)base;
+    page->offset = length;
+    page->size = length;
+    page->live = 1;
+    page->base = (uint8_t *)base;
+    page->mapped = (length + RK_ARENA_OS_PAGE_SIZE - 1) & ~(size_t)(RK_ARENA_OS_PAGE_SIZE - 1);
+    page->next = RK_ARENA_NO_PAGE;
+    page->owner = RK_NORMAL;
+    page->kind = RK_ARENA_KIND_FILE;
+    page->cold = RK_ARENA_COLD_HOT;
+    page->armedAt = 0;
+    page->packed = NULL;
+    page->packedSize = 0;
+    page->packedSpan = 0;
+    page->lastUse = ++arena->clock;
+    page->lruPrev = RK_ARENA_NO_PAGE;
+    page->lruNext = RK_ARENA_NO_PAGE;
+    page->spillOffset = 0;
+    rkIndexPage(arena, i);
+
+    if (size)
+    {
+        *size = length;
+    }
+
+    return base;
+#else
+    return rkArenaReadFile(arena, path, size);
+#endif /* RK_ARENA_PLATFORM_LINUX */
+}
+
+size_t rkArenaWritev(rkArena *arena, int fd, const rkArenaRegion *regions, size_t n, unsigned flags)
+{
+    RK_ARENA_ASSERT(arena != NULL, "Cannot write from a NULL arena");
+    RK_ARENA_ASSERT(n == 0 || regions != NULL, "Cannot write NULL regions");
+
+    size_t written = 0;
+#if defined(RK_ARENA_PLATFORM_LINUX)
+    size_t next = 0; // The first region not written completely
+    size_t skip = 0; // The bytes of that region that were written already
+    while (next < n)
+    {
+        struct iovec iov[RK_ARENA_IOV_BATCH];
+        size_t count = 0;
+        for (size_t i = next; i < n; i++)
+        {
+            const size_t offset = i == next ? skip : 0;
+            if (regions[i].size == offset)
+            {
+                continue;
+            }
+
+            uint8_t *const data = (uint8_t *)regions[i].data + offset;
+            const size_t length = regions[i].size - offset;
+            RK_ARENA_ASSERT(rkArenaOwns(arena, data), "Region does not belong to the arena: %p", (void *)data);
+            rkWarmRange(arena, data, length);
+            if (count > 0 && (uint8_t *)iov[count - 1].iov_base + iov[count - 1].iov_len == data)
+            {
+                iov[count - 1].iov_len += length;
+                continue;
+            }
+
+            if (count == RK_ARENA_IOV_BATCH)
+            {
+                break;
+            }
+
+            iov[count].iov_base = (void *)data;
+            iov[count].iov_len = length;
+            count++;
+        }
+
+        if (count == 0)
+        {
+            break;
+        }
+
+        ssize_t r = -1;
+        if (flags & RK_ARENA_WRITE_GIFT)
+        {
+#if defined(SYS_vmsplice)
+            r = (ssize_t)syscall(SYS_vmsplice, fd, iov, (unsigned long)count, RK_ARENA_SPLICE_F_GIFT);
+#else
+            errno = ENOSYS;
+#endif /* SYS_vmsplice */
+        }
+        else
+        {
+            r = writev(fd, iov, (int)count);
+        }
+
+        if (r < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (r <= 0)
+        {
+            break;
+        }
+
+        written += (size_t)r;
+        for (size_t left = (size_t)r; left > 0 && next < n; )
+        {
+            const size_t remaining = regions[next].size - skip;
+            if (left < remaining)
+            {
+                skip += left;
+                break;
+            }
+
+            left -= remaining;
+            next++;
+            skip = 0;
+        }
+    }
+#elif defined(RK_ARENA_PLATFORM_WINDOWS)
+    (void)flags;
+    for (size_t i = 0; i < n; i++)
+    {
+        const uint8_t *const data = (const uint8_t *)regions[i].data;
+        size_t done = 0;
+        while (done < regions[i].size)
+        {
+            const size_t left = regions[i].size - done;
+            const int r = _write(fd, data + done, left > INT_MAX ? INT_MAX : (unsigned)left);
+            if (r <= 0)
+            {
+                return written;
+            }
+
+            done += (size_t)r;
+            written += (size_t)r;
+        }
+    }
+#else
+    (void)fd;
+    (void)regions;
+    (void)n;
+    (void)flags;
+#endif /* RK_ARENA_PLATFORM_XXX */
+
+    return written;
+}
+
+void *rkArenaRead(rkArena *arena, int fd, size_t maxBytes, size_t *numRead)
+{
+    RK_ARENA_ASSERT(arena != NULL, "Cannot read into a NULL arena");
+    RK_ARENA_ASSERT(numRead != NULL, "Cannot write the number of bytes read to NULL");
+
+    return rkIngest(arena, fd, maxBytes, -1, numRead);
+}
+
+void *rkArenaRecv(rkArena *arena, int fd, size_t maxBytes, int flags, size_t *numRead)
+{
+    RK_ARENA_ASSERT(arena != NULL, "Cannot receive into a NULL arena");
+    RK_ARENA_ASSERT(numRead != NULL, "Cannot write the number of bytes received to NULL");
+    RK_ARENA_ASSERT(flags >= 0, "Invalid recv flags: %d", flags);
+
+    return rkIngest(arena, fd, maxBytes, flags, numRead);
+}
+
+int rkArenaFreeze(rkArena *arena, int mergeable)
+{
+    RK_ARENA_ASSERT(arena != NULL, "Cannot freeze a NULL arena");
+    if (arena->frozen)
+    {
+        return 1;
+    }
+
+    rkWarmArena(arena);
+
+    arena->frozen = 1;
+    arena->mergeable = mergeable;
+    for (size_t i = 0; i < arena->numPages; i++)
+    {
+        const rkAllocPage *const page = &arena->pages[i];
+        if (page->owner >= RK_ARENA_HINT_COUNT || page->kind == RK_ARENA_KIND_FILE)
+        {
+            continue;
+        }
+
+        if (!rkProtectPage(page, 0))
+        {
+            rkArenaThaw(arena);
+            return 0;
+        }
+
+#if defined(RK_ARENA_PLATFORM_LINUX)
+        if (mergeable)
+        {
+            madvise(page->base, page->mapped, RK_ARENA_MADV_MERGEABLE);
+        }
+#endif /* RK_ARENA_PLATFORM_LINUX */
+    }
+
+    return 1;
+}
+
+void rkArenaThaw(rkArena *arena)
+{
+    RK_ARENA_ASSERT(arena != NULL, "Cannot thaw a NULL arena");
+    if (!arena->frozen)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < arena->numPages; i++)
+    {
+        const rkAllocPage *const page = &arena->pages[i];
+        if (page->owner >= RK_ARENA_HINT_COUNT || page->kind == RK_ARENA_KIND_FILE)
+        {
+            continue;
+        }
+
+#if defined(RK_ARENA_PLATFORM_LINUX)
+        if (arena->mergeable)
+        {
+            madvise(page->base, page->mapped, RK_ARENA_MADV_UNMERGEABLE);
+        }
+#endif /* RK_ARENA_PLATFORM_LINUX */
+
+        rkProtectPage(page, 1);
+    }
+
+    arena->frozen = 0;
+    arena->mergeable = 0;
+}
+
+int rkArenaGetKsmStats(rkArenaKsmStats *stats)
+{
+    RK_ARENA_ASSERT(stats != NULL, "Cannot write the KSM stats to NULL");
+
+    stats->mergingPages = rkReadCounter(RK_ARENA_KSM_PROCESS_PATH);
+    stats->pagesShared = rkReadCounter(RK_ARENA_KSM_SHARED_PATH);
+    stats->pagesSharing = rkReadCounter(RK_ARENA_KSM_SHARING_PATH);
+
+    return stats->mergingPages >= 0;
+}
+
+size_t rkArenaCompressCold(rkArena *arena, unsigned intervalMs)
+{
+    RK_ARENA_ASSERT(arena != NULL, "Cannot compress a NULL arena");
+    if (!(arena->flags & RK_ARENA_FLAG_COMPRESS) || arena->frozen)
+    {
+        return 0;
+    }
+
+    size_t released = 0;
+#if defined(RK_ARENA_PLATFORM_LINUX)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    const size_t now = (size_t)ts.tv_sec * 1000 + (size_t)ts.tv_nsec / 1000000;
+
+    for (size_t i = 0; i < arena->numPages; i++)
+    {
+        rkAllocPage *const page = &arena->pages[i];
+        if (page->owner >= RK_ARENA_HINT_COUNT || page->kind != RK_ARENA_KIND_ANON || page->offset == 0)
+        {
+            continue;
+        }
+
+        rkLockTables(arena);
+        rkDropPacked(arena, i);
+        if (page->cold == RK_ARENA_COLD_HOT && mprotect(page->base, page->mapped, PROT_NONE) == 0)
+        {
+            page->cold = RK_ARENA_COLD_ARMED;
+            page->armedAt = now;
+        }
+        else if (page->cold == RK_ARENA_COLD_ARMED && now - page->armedAt >= intervalMs)
+        {
+            released += rkPackPage(arena, i);
+        }
+        rkUnlockTables(arena);
+    }
+#else
+    (void)intervalMs;
+#endif /* RK_ARENA_PLATFORM_LINUX */
+
+    return released;
+}
+
+int rkArenaSetSpill(rkArena *arena, const char *directory, size_t residentBudget)
+{
+    RK_ARENA_ASSERT(arena != NULL, "Cannot spill a NULL arena");
+    RK_ARENA_ASSERT(directory != NULL, "Cannot spill to a NULL directory");
+
+#if defined(RK_ARENA_PLATFORM_LINUX)
+    if (arena->spillFd < 0)
+    {
+        char path[4096];
+        const int length = snprintf(path, sizeof(path), "%s/%s", directory, RK_ARENA_SPILL_TEMPLATE);
+        if (length < 0 || (size_t)length >= sizeof(path))
+        {
+            return 0;
+        }
+
+        const int fd = mkstemp(path);
+        if (fd < 0)
+        {
+            return 0;
+        }
+
+        // The file only needs to live as long as its descriptor
+        unlink(path);
+        arena->spillFd = fd;
+    }
+
+    arena->spillBudget = residentBudget;
+    rkEnforceBudget(arena);
+    return 1;
+#else
+    (void)directory;
+    (void)residentBudget;
+    return 0;
+#endif /* RK_ARENA_PLATFORM_LINUX */
+}
+
+void rkArenaGetStats(const rkArena *arena, rkArenaStats *stats)
+{
+    RK_ARENA_ASSERT(arena != NULL, "Cannot get the stats of a NULL arena");
+    RK_ARENA_ASSERT(stats != NULL, "Cannot write the stats to NULL");
+
+    memset(stats, 0, sizeof(rkArenaStats));
+    for (size_t i = 0; i < arena->numPages; i++)
+    {
+        const rkAllocPage *const page = &arena->pages[i];
+        if (page->owner == RK_ARENA_PAGE_CACHED)
+        {
+            stats->cachedPageCount++;
+            continue;
+        }
+
+        if (page->owner >= RK_ARENA_HINT_COUNT)
+        {
+            continue;
+        }
+
+        stats->pageCount++;
+        stats->capacityBytes += page->size;
+        stats->usedBytes += page->offset;
+        if (page->cold == RK_ARENA_COLD_PACKED)
+        {
+            stats->packedPageCount++;
+            stats->packedBytes += page->packedSize;
+        }
+
+        if (page->kind == RK_ARENA_KIND_SPILLED)
+        {
+            stats->spilledPageCount++;
+            stats->spilledBytes += page->size;
+        }
+
+        const rkPageChain *const chain = &arena->chains[page->owner];
+        if (i == chain->curr)
+        {
+            continue;
+        }
+
+        int isTail = 0;
+        for (size_t t = 0; t < chain->numTails; t++)
+        {
+            isTail |= chain->tails[t] == i;
+        }
+
+        if (isTail)
+        {
+            stats->tailFreeBytes += page->size - page->offset;
+        }
+        else
+        {
+            stats->wastedBytes += page->size - page->offset;
+        }
+    }
+
+    stats->cachedBytes = arena->cachedBytes;
+    stats->tailReusedBytes = arena->tailReused;
+}
+
+int rkArenaSetNumaPolicy(rkArena *arena, rkArenaNumaPolicy policy, int node)
+{
+    RK_ARENA_ASSERT(arena != NULL, "Cannot set the NUMA policy of a NULL arena");
+
+    unsigned long online[RK_ARENA_NUMA_MASK_WORDS];
+    memset(online, 0, sizeof(online));
+    const int numNodes = rkReadNumaNodes(online);
+
+    memset(arena->numaMask, 0, sizeof(arena->numaMask));
+    if (policy == RK_ARENA_NUMA_BIND)
+    {
+        if (node < 0 || node >= RK_ARENA_MAX_NUMA_NODES)
+        {
+            return 0;
+        }
+
+        const unsigned long bit = 1UL << ((size_t)node % RK_ARENA_NUMA_MASK_BITS);
+        if (!(online[(size_t)node / RK_ARENA_NUMA_MASK_BITS] & bit))
+        {
+            return 0;
+        }
+
+        arena->numaMask[(size_t)node / RK_ARENA_NUMA_MASK_BITS] = bit;
+    }
+    else if (policy == RK_ARENA_NUMA_INTERLEAVE)
+    {
+        memcpy(arena->numaMask, online, sizeof(online));
+    }
+
+    // The topology is read once here, so that mapping pages stays off sysfs
+    arena->numaPolicy = policy;
+    arena->numaNodes = numNodes;
+    for (size_t i = 0; i < arena->numPages; i++)
+    {
+        const rkAllocPage *const page = &arena->pages[i];
+        if (page->owner != RK_ARENA_PAGE_UNUSED && page->kind == RK_ARENA_KIND_ANON)
+        {
+            rkApplyNumaPolicy(arena, page->base, page->mapped, RK_ARENA_MPOL_MF_MOVE);
+        }
+    }
+
+    return 1;
+}
+
+void rkArenaSetNumaTopology(const char *onlinePath)
+{
+    if (!onlinePath)
+    {
+        onlinePath = RK_ARENA_NUMA_ONLINE_PATH;
+    }
+
+    snprintf(rkNumaOnlinePath, sizeof(rkNumaOnlinePath), "%s", onlinePath);
+}
+
+int rkArenaNumaNodeCount(void)
+{
+    return rkReadNumaNodes(NULL);
+}
+
+rkArenaPool *rkCreateArenaPool(size_t pageSize, unsigned flags, size_t shapePages, size_t maxRetainedBytes)
+{
+    rkArenaPool *const pool = (rkArenaPool *)rkOsMalloc(sizeof(rkArenaPool));
+    if (!pool)
+    {
+        return NULL;
+    }
+
+    if (flags & RK_ARENA_FLAG_DIRECT_IO)
+    {
+        // Match the page size of the arenas, which is rounded to whole blocks
+        pageSize = (pageSize + RK_ARENA_DIRECT_BLOCK - 1) & ~(size_t)(RK_ARENA_DIRECT_BLOCK - 1);
+    }
+
+    memset(pool->shards, 0, sizeof(pool->shards));
+    pool->pageSize = pageSize;
+    pool->flags = flags;
+    pool->shapePages = shapePages;
+    pool->maxRetained = maxRetainedBytes;
+    pool->retained = 0;
+
+    return pool;
+}
+
+void rkFreeArenaPool(rkArenaPool *pool)
+{
+    RK_ARENA_ASSERT(pool != NULL, "Cannot free a NULL arena pool");
+
+    rkArenaPoolTrim(pool, 0);
+    rkOsFree(pool, sizeof(rkArenaPool));
+}
+
+rkArena *rkArenaPoolAcquire(rkArenaPool *pool)
+{
+    RK_ARENA_ASSERT(pool != NULL, "Cannot acquire from a NULL arena pool");
+
+    const size_t home = rkPoolShardIndex();
+    for (size_t i = 0; i < RK_ARENA_POOL_SHARDS; i++)
+    {
+        rkArenaPoolShard *const shard = &pool->shards[(home + i) % RK_ARENA_POOL_SHARDS];
+        if (!RK_ARENA_ATOMIC_LOAD_PTR(&shard->head))
+        {
+            continue;
+        }
+
+        RK_ARENA_SPIN_LOCK(&shard->lock);
+        rkArena *const arena = shard->head;
+        if (arena)
+        {
+            shard->head = arena->poolNext;
+        }
+        RK_ARENA_SPIN_UNLOCK(&shard->lock);
+
+        if (arena)
+        {
+            RK_ARENA_ATOMIC_SUB(&pool->retained, rkArenaFootprint(arena));
+            arena->poolNext = NULL;
+            return arena;
+        }
+    }
+
+    rkArena *const arena = rkNewArena(pool->pageSize, pool->flags);
+    if (arena && pool->shapePages > 1)
+    {
+        rkPrewarmArena(arena, pool->shapePages);
+    }
+
+    return arena;
+}
+
+void rkArenaPoolRelease(rkArenaPool *pool, rkArena *arena)
+{
+    RK_ARENA_ASSERT(pool != NULL, "Cannot release to a NULL arena pool");
+    RK_ARENA_ASSERT(arena != NULL, "Cannot release a NULL arena");
+    RK_ARENA_ASSERT(arena->pageSize == pool->pageSize, "The arena does not belong to this pool");
+
+    rkResetArena(arena);
+    if (pool->shapePages > 0)
+    {
+        rkArenaTrim(arena, (pool->shapePages - 1) * pool->pageSize);
+    }
+
+    // The footprint is reserved before the arena is published, so that
+    // concurrent releases cannot take the pool past its cap together
+    const size_t footprint = rkArenaFootprint(arena);
+    if (pool->maxRetained == 0)
+    {
+        RK_ARENA_ATOMIC_ADD(&pool->retained, footprint);
+    }
+    else
+    {
+        for (;;)
+        {
+            size_t retained = RK_ARENA_ATOMIC_LOAD(&pool->retained);
+            if (retained + footprint > pool->maxRetained)
+            {
+                rkFreeArena(arena);
+                return;
+            }
+
+            if (RK_ARENA_ATOMIC_CAS(&pool->retained, retained, retained + footprint))
+            {
+                break;
+            }
+        }
+    }
+
+    rkArenaPoolShard *const shard = &pool->shards[rkPoolShardIndex()];
+    RK_ARENA_SPIN_LOCK(&shard->lock);
+    arena->poolNext = shard->head;
+    shard->head = arena;
+    RK_ARENA_SPIN_UNLOCK(&shard->lock);
+}
+
+size_t rkArenaPoolTrim(rkArenaPool *pool, size_t keepBytes)
+{
+    RK_ARENA_ASSERT(pool != NULL, "Cannot trim a NULL arena pool");
+
+    size_t released = 0;
+    for (size_t i = 0; i < RK_ARENA_POOL_SHARDS; i++)
+    {
+        rkArenaPoolShard *const shard = &pool->shards[i];
+        while (RK_ARENA_ATOMIC_LOAD(&pool->retained) > keepBytes)
+        {
+            RK_ARENA_SPIN_LOCK(&shard->lock);
+            rkArena *const arena = shard->head;
+            if (arena)
+            {
+                shard->head = arena->poolNext;
+            }
+            RK_ARENA_SPIN_UNLOCK(&shard->lock);
+
+            if (!arena)
+            {
+                break;
+            }
+
+            const size_t footprint = rkArenaFootprint(arena);
+            RK_ARENA_ATOMIC_SUB(&pool->retained, footprint);
+            released += footprint;
+            rkFreeArena(arena);
+        }
+    }
+
+    return released;
+}
+
+size_t rkArenaPoolRetainedBytes(const rkArenaPool *pool)
+{
+    RK_ARENA_ASSERT(pool != NULL, "Cannot query a NULL arena pool");
+    return RK_ARENA_ATOMIC_LOAD(&pool->retained);
+}
+
+void rkDebugArena(const rkArena *arena)
+{
+    if (!arena)
+    {
+        printf("Arena { NULL }\n");
+        return;
+    }
+
+    printf("Arena {\n");
+    printf("\tpageSize=%zu\n", arena->pageSize);
+    printf("\tcachedBytes=%zu\n", arena->cachedBytes);
+    printf("\tnumaPolicy=%d\n", (int)arena->numaPolicy);
+    for (size_t h = 0; h < RK_ARENA_HINT_COUNT; h++)
+    {
+        if (h != RK_NORMAL && arena->chains[h].curr == RK_ARENA_NO_PAGE)
+        {
+            continue;
+        }
+
+        printf("\tchains[%zu]=", h);
+        for (size_t i = 0; i < arena->numPages; i++)
+        {
+            const rkAllocPage *const p = &arena->pages[i];
+            if (p->owner == h)
+            {
+                printf("AllocPage { region=%p, offset=%zu, size=%zu } -> ", (void *)p->region, p->offset, p->size);
+            }
+        }
+        printf("NULL\n");
+    }
+    printf("}\n");
+}
+
+// --- utility functions ------------------------------------------------------
+
+static rkArena *rkNewArena(size_t pageSize, unsigned flags)
+{
+    rkArena *const arena = (rkArena *)rkOsMalloc(sizeof(rkArena));
+    if (!arena)
+    {
+        return NULL;
+    }
+
+    if (flags & RK_ARENA_FLAG_DIRECT_IO)
+    {
+        // Block aligned allocations need block aligned regions
+        flags |= RK_ARENA_FLAG_NO_COLORING;
+        pageSize = (pageSize + RK_ARENA_DIRECT_BLOCK - 1) & ~(size_t)(RK_ARENA_DIRECT_BLOCK - 1);
+    }
+
+    arena->pageSize = pageSize;
+    arena->flags = flags;
+    arena->color = RK_ARENA_ATOMIC_INC(&rkColorSeed) * 5;
+    for (size_t h = 0; h < RK_ARENA_HINT_COUNT; h++)
+    {
+        arena->chains[h].curr = RK_ARENA_NO_PAGE;
+        arena->chains[h].numTails = 0;
+    }
+    arena->cache = RK_ARENA_NO_PAGE;
+    arena->cachedBytes = 0;
+    arena->tailReused = 0;
+    arena->pages = NULL;
+    arena->numPages = 0;
+    arena->pagesCap = 0;
+    arena->unused = RK_ARENA_NO_PAGE;
+    arena->index = NULL;
+    arena->numIndexed = 0;
+    arena->indexCap = 0;
+    arena->numaPolicy = RK_ARENA_NUMA_DEFAULT;
+    memset(arena->numaMask, 0, sizeof(arena->numaMask));
+    arena->numaNodes = 1;
+    arena->frozen = 0;
+    arena->mergeable = 0;
+    arena->clock = 0;
+    arena->lruHead = RK_ARENA_NO_PAGE;
+    arena->lruTail = RK_ARENA_NO_PAGE;
+    arena->residentBytes = 0;
+    arena->spillFd = -1;
+    arena->spillBudget = 0;
+    arena->spillEnd = 0;
+    arena->numSpilled = 0;
+    arena->coldLock = 0;
+    arena->trimRequested = 0;
+    arena->trimmedBytes = 0;
+    arena->poolNext = NULL;
+
+    if (flags & RK_ARENA_FLAG_COMPRESS)
+    {
+#if defined(RK_ARENA_PLATFORM_LINUX)
+        // An arena the fault handler cannot see would crash on its first
+        // packed page, so running out of room fails the creation
+        if (!rkRegisterColdArena(arena))
+        {
+            rkFreeArena(arena);
+            return NULL;
+        }
+#else
+        arena->flags &= ~(unsigned)RK_ARENA_FLAG_COMPRESS;
+#endif /* RK_ARENA_PLATFORM_LINUX */
+    }
+
+    const size_t page = rkMapPage(arena, pageSize, RK_NORMAL);
+    if (page == RK_ARENA_NO_PAGE)
+    {
+        rkFreeArena(arena);
+        return NULL;
+    }
+
+    arena->chains[RK_NORMAL].curr = page;
+    return arena;
+}
+
+static size_t rkMapPage(rkArena *arena, size_t size, unsigned owner)
+{
+    RK_ARENA_ASSERT(size > 0, "Page size cannot be zero");
+    if (size > SIZE_MAX - 2 * RK_ARENA_OS_PAGE_SIZE || !rkReservePages(arena, 1))
+    {
+        return RK_ARENA_NO_PAGE;
+    }
+
+    const size_t colorOffset = rkNextColor(arena, size);
+    const size_t mapped = (colorOffset + size + RK_ARENA_OS_PAGE_SIZE - 1) & ~(size_t)(RK_ARENA_OS_PAGE_SIZE - 1);
+    uint8_t *const base = (uint8_t *)rkOsMalloc(mapped);
+    if (!base)
+    {
+        return RK_ARENA_NO_PAGE;
+    }
+
+    const size_t i = rkNewDescriptor(arena);
+    rkAllocPage *const page = &arena->pages[i];
+    page->region = base + colorOffset;
+    page->offset = 0;
+    page->size = size;
+    page->live = 0;
+    page->base = base;
+    page->mapped = mapped;
+    page->next = RK_ARENA_NO_PAGE;
+    page->owner = owner;
+    page->kind = RK_ARENA_KIND_ANON;
+    page->cold = RK_ARENA_COLD_HOT;
+    page->armedAt = 0;
+    page->packed = NULL;
+    page->packedSize = 0;
+    page->packedSpan = 0;
+    page->lastUse = 0;
+    page->lruPrev = RK_ARENA_NO_PAGE;
+    page->lruNext = RK_ARENA_NO_PAGE;
+    page->spillOffset = 0;
+
+    arena->residentBytes += mapped;
+    if (owner < RK_ARENA_HINT_COUNT)
+    {
+        rkQueuePage(arena, i);
+    }
+
+    rkApplyNumaPolicy(arena, base, mapped, 0);
+    rkApplyForkPolicy(arena, base, mapped);
+    rkIndexPage(arena, i);
+
+    if (arena->spillFd >= 0 && owner < RK_ARENA_HINT_COUNT)
+    {
+        rkEnforceBudget(arena);
+    }
+
+    return i;
+}
+
+static void rkUnmapPage(rkArena *arena, size_t page)
+{
+    rkAllocPage *const p = &arena->pages[page];
+    if (p->kind == RK_ARENA_KIND_ANON)
+    {
+        if (p->owner < RK_ARENA_HINT_COUNT)
+        {
+            rkUnqueuePage(arena, page);
+        }
+
+        arena->residentBytes -= p->mapped;
+    }
+
+    rkUnindexPage(arena, page);
+    rkOsFree(p->base, p->mapped);
+
+    free(p->packed);
+    p->packed = NULL;
+    p->cold = RK_ARENA_COLD_HOT;
+    if (p->kind == RK_ARENA_KIND_SPILLED)
+    {
+        rkReleaseSpill(arena, p);
+    }
+
+    p->owner = RK_ARENA_PAGE_UNUSED;
+    p->next = arena->unused;
+    arena->unused = page;
+}
+
+static size_t rkObtainPage(rkArena *arena, unsigned owner)
+{
+    rkHonourTrim(arena);
+
+    const size_t page = arena->cache;
+    if (page == RK_ARENA_NO_PAGE)
+    {
+        return rkMapPage(arena, arena->pageSize, owner);
+    }
+
+    rkAllocPage *const p = &arena->pages[page];
+    arena->cache = p->next;
+    arena->cachedBytes -= p->size;
+
+    p->offset = 0;
+    p->live = 0;
+    p->next = RK_ARENA_NO_PAGE;
+    p->owner = owner;
+    rkQueuePage(arena, page);
+
+    return page;
+}
+
+static void rkQueuePage(rkArena *arena, size_t page)
+{
+    rkAllocPage *const p = &arena->pages[page];
+    p->lastUse = ++arena->clock;
+    p->lruPrev = arena->lruTail;
+    p->lruNext = RK_ARENA_NO_PAGE;
+    if (arena->lruTail != RK_ARENA_NO_PAGE)
+    {
+        arena->pages[arena->lruTail].lruNext = page;
+    }
+    else
+    {
+        arena->lruHead = page;
+    }
+
+    arena->lruTail = page;
+}
+
+static void rkUnqueuePage(rkArena *arena, size_t page)
+{
+    rkAllocPage *const p = &arena->pages[page];
+    if (p->lruPrev != RK_ARENA_NO_PAGE)
+    {
+        arena->pages[p->lruPrev].lruNext = p->lruNext;
+    }
+    else
+    {
+        arena->lruHead = p->lruNext;
+    }
+
+    if (p->lruNext != RK_ARENA_NO_PAGE)
+    {
+        arena->pages[p->lruNext].lruPrev = p->lruPrev;
+    }
+    else
+    {
+        arena->lruTail = p->lruPrev;
+    }
+
+    p->lruPrev = RK_ARENA_NO_PAGE;
+    p->lruNext = RK_ARENA_NO_PAGE;
+}
+
+static void rkTouchPage(rkArena *arena, size_t page)
+{
+    const rkAllocPage *const p = &arena->pages[page];
+    if (p->owner < RK_ARENA_HINT_COUNT && p->kind == RK_ARENA_KIND_ANON && page != arena->lruTail)
+    {
+        rkUnqueuePage(arena, page);
+        rkQueuePage(arena, page);
+        return;
+    }
+
+    arena->pages[page].lastUse = ++arena->clock;
+}
+
+static void rkHonourTrim(rkArena *arena)
+{
+    if (RK_ARENA_ATOMIC_LOAD(&arena->trimRequested) && RK_ARENA_ATOMIC_EXCHANGE(&arena->trimRequested, 0))
+    {
+        RK_ARENA_ATOMIC_ADD(&arena->trimmedBytes, rkArenaTrim(arena, 0));
+    }
+}
+
+static int rkReservePages(rkArena *arena, size_t count)
+{
+    // The old tables are freed while they are swapped, so the fault handler
+    // has to stay out of them
+    rkLockTables(arena);
+    rkAllocPage *const pages = (rkAllocPage *)rkGrowTable(arena->pages, &arena->pagesCap, sizeof(rkAllocPage), arena->numPages, arena->numPages + count);
+    if (pages)
+    {
+        arena->pages = pages;
+    }
+
+    size_t *const index = pages ? (size_t *)rkGrowTable(arena->index, &arena->indexCap, sizeof(size_t), arena->numIndexed, arena->numIndexed + count) : NULL;
+    if (index)
+    {
+        arena->index = index;
+    }
+    rkUnlockTables(arena);
+
+    return index != NULL;
+}
+
+static void rkLockTables(rkArena *arena)
+{
+    if (arena->flags & RK_ARENA_FLAG_COMPRESS)
+    {
+        RK_ARENA_SPIN_LOCK(&arena->coldLock);
+    }
+}
+
+static void rkUnlockTables(rkArena *arena)
+{
+    if (arena->flags & RK_ARENA_FLAG_COMPRESS)
+    {
+        RK_ARENA_SPIN_UNLOCK(&arena->coldLock);
+    }
+}
+
+static void *rkGrowTable(void *table, size_t *capacity, size_t elemSize, size_t used, size_t needed)
+{
+    if (needed <= *capacity)
+    {
+        return table;
+    }
+
+    size_t newCapacity = *capacity ? *capacity : RK_ARENA_OS_PAGE_SIZE / elemSize;
+    while (newCapacity < needed)
+    {
+        newCapacity *= 2;
+    }
+
+    void *const newTable = rkOsMalloc(newCapacity * elemSize);
+    if (!newTable)
+    {
+        return NULL;
+    }
+
+    if (table)
+    {
+        memcpy(newTable, table, used * elemSize);
+        rkOsFree(table, *capacity * elemSize);
+    }
+
+    *capacity = newCapacity;
+    return newTable;
+}
+
+static size_t rkNewDescriptor(rkArena *arena)
+{
+    if (arena->unused != RK_ARENA_NO_PAGE)
+    {
+        const size_t page = arena->unused;
+        arena->unused = arena->pages[page].next;
+        return page;
+    }
+
+    RK_ARENA_ASSERT(arena->numPages < arena->pagesCap, "The page table is full");
+    return arena->numPages++;
+}
+
+static size_t rkNextColor(rkArena *arena, size_t size)
+{
+#if defined(RK_ARENA_PLATFORM_LINUX) || defined(RK_ARENA_PLATFORM_WINDOWS)
+    if (arena->flags & RK_ARENA_FLAG_NO_COLORING)
+    {
+        return 0;
+    }
+
+    // Regions that fill whole OS pages leave no slack, so their colors cost
+    // one more OS page
+    const size_t slack = (RK_ARENA_OS_PAGE_SIZE - size % RK_ARENA_OS_PAGE_SIZE) % RK_ARENA_OS_PAGE_SIZE;
+
+    size_t colors = slack ? slack / RK_ARENA_CACHE_LINE + 1 : RK_ARENA_CACHE_COLORS;
+    if (colors > RK_ARENA_CACHE_COLORS)
+    {
+        colors = RK_ARENA_CACHE_COLORS;
+    }
+
+    return (arena->color++ % colors) * RK_ARENA_CACHE_LINE;
+#else
+    // Without page aligned mappings coloring has no effect
+    (void)arena;
+    (void)size;
+    return 0;
+#endif /* RK_ARENA_PLATFORM_XXX */
+}
+
+inline static size_t rkPageFree(const rkArena *arena, size_t page)
+{
+    return arena->pages[page].size - arena->pages[page].offset;
+}
+
+static size_t rkIndexUpperBound(const rkArena *arena, const void *ptr)
+{
+    size_t lo = 0;
+    size_t hi = arena->numIndexed;
+    while (lo < hi)
+    {
+        const size_t mid = lo + (hi - lo) / 2;
+        if ((uintptr_t)arena->pages[arena->index[mid]].region <= (uintptr_t)ptr)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+static void rkIndexPage(rkArena *arena, size_t page)
+{
+    RK_ARENA_ASSERT(arena->numIndexed < arena->indexCap, "The page index is full");
+
+    const size_t i = rkIndexUpperBound(arena, arena->pages[page].region);
+    rkLockTables(arena);
+    memmove(&arena->index[i + 1], &arena->index[i], (arena->numIndexed - i) * sizeof(size_t));
+    arena->index[i] = page;
+    arena->numIndexed++;
+    rkUnlockTables(arena);
+}
+
+static void rkUnindexPage(rkArena *arena, size_t page)
+{
+    const size_t i = rkIndexUpperBound(arena, arena->pages[page].region);
+    if (i == 0 || arena->index[i - 1] != page)
+    {
+        return;
+    }
+
+    rkLockTables(arena);
+    memmove(&arena->index[i - 1], &arena->index[i], (arena->numIndexed - i) * sizeof(size_t));
+    arena->numIndexed--;
+    rkUnlockTables(arena);
+}
+
+static size_t rkFindPage(const rkArena *arena, const void *ptr)
+{
+    const size_t i = rkIndexUpperBound(arena, ptr);
+    if (i == 0)
+    {
+        return RK_ARENA_NO_PAGE;
+    }
+
+    const size_t page = arena->index[i - 1];
+    const rkAllocPage *const p = &arena->pages[page];
+    return (uintptr_t)ptr < (uintptr_t)(p->region + p->size) ? page : RK_ARENA_NO_PAGE;
+}
+
+static void rkApplyNumaPolicy(const rkArena *arena, void *ptr, size_t numBytes, unsigned flags)
+{
+    if (arena->numaPolicy == RK_ARENA_NUMA_DEFAULT)
+    {
+        return;
+    }
+
+#if defined(RK_ARENA_PLATFORM_LINUX) && defined(SYS_mbind)
+    if (arena->numaNodes < 2)
+    {
+        return;
+    }
+
+    int mode = RK_ARENA_MPOL_DEFAULT;
+    switch (arena->numaPolicy)
+    {
+        case RK_ARENA_NUMA_BIND:        mode = RK_ARENA_MPOL_BIND; break;
+        case RK_ARENA_NUMA_INTERLEAVE:  mode = RK_ARENA_MPOL_INTERLEAVE; break;
+        case RK_ARENA_NUMA_FIRST_TOUCH: mode = RK_ARENA_MPOL_LOCAL; break;
+        default:                        break;
+    }
+
+    const unsigned long *const mask = mode == RK_ARENA_MPOL_LOCAL ? NULL : arena->numaMask;
+    syscall(SYS_mbind, ptr, numBytes, mode, mask, (unsigned long)RK_ARENA_MAX_NUMA_NODES + 1, flags);
+#else
+    (void)ptr;
+    (void)numBytes;
+    (void)flags;
+#endif /* RK_ARENA_PLATFORM_LINUX */
+}
+
+static void rkApplyForkPolicy(const rkArena *arena, void *ptr, size_t numBytes)
+{
+#if defined(RK_ARENA_PLATFORM_LINUX)
+    if (arena->flags & RK_ARENA_FLAG_WIPEONFORK)
+    {
+        if (madvise(ptr, numBytes, RK_ARENA_MADV_WIPEONFORK) == 0)
+        {
+            return;
+        }
+
+        madvise(ptr, numBytes, RK_ARENA_MADV_DONTFORK);
+    }
+    else if (arena->flags & RK_ARENA_FLAG_DONTFORK)
+    {
+        madvise(ptr, numBytes, RK_ARENA_MADV_DONTFORK);
+    }
+#else
+    (void)arena;
+    (void)ptr;
+    (void)numBytes;
+#endif /* RK_ARENA_PLATFORM_LINUX */
+}
+
+static int rkProtectPage(const rkAllocPage *page, int writable)
+{
+#if defined(RK_ARENA_PLATFORM_LINUX)
+    return mprotect(page->base, page->mapped, writable ? PROT_READ | PROT_WRITE : PROT_READ) == 0;
+#elif defined(RK_ARENA_PLATFORM_WINDOWS)
+    DWORD old = 0;
+    return VirtualProtect(page->base, page->mapped, writable ? PAGE_READWRITE : PAGE_READONLY, &old) != FALSE;
+#else
+    (void)page;
+    (void)writable;
+    return 1;
+#endif /* RK_ARENA_PLATFORM_XXX */
+}
+
+static int rkRegisterColdArena(rkArena *arena)
+{
+#if defined(RK_ARENA_PLATFORM_LINUX)
+    int ok = 0;
+    RK_ARENA_SPIN_LOCK(&rkColdLock);
+    if (!rkColdHandlerInstalled)
+    {
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_sigaction = rkColdFaultHandler;
+        action.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        rkColdHandlerInstalled = sigaction(SIGSEGV, &action, &rkPrevSegvAction) == 0;
+    }
+
+    for (size_t i = 0; rkColdHandlerInstalled && i < RK_ARENA_MAX_COLD_ARENAS; i++)
+    {
+        if (!rkColdArenas[i])
+        {
+            __atomic_store_n(&rkColdArenas[i], arena, __ATOMIC_RELEASE);
+            ok = 1;
+            break;
+        }
+    }
+    RK_ARENA_SPIN_UNLOCK(&rkColdLock);
+
+    return ok;
+#else
+    (void)arena;
+    return 0;
+#endif /* RK_ARENA_PLATFORM_LINUX */
+}
+
+static void rkUnregisterColdArena(rkArena *arena)
+{
+#if defined(RK_ARENA_PLATFORM_LINUX)
+    RK_ARENA_SPIN_LOCK(&rkColdLock);
+    for (size_t i = 0; i < RK_ARENA_MAX_COLD_ARENAS; i++)
+    {
+        if (rkColdArenas[i] == arena)
+        {
+            __atomic_store_n(&rkColdArenas[i], NULL, __ATOMIC_RELEASE);
+            break;
+        }
+    }
+    RK_ARENA_SPIN_UNLOCK(&rkColdLock);
+#else
+    (void)arena;
+#endif /* RK_ARENA_PLATFORM_LINUX */
+}
+
+#if defined(RK_ARENA_PLATFORM_LINUX)
+static void rkColdFaultHandler(int sig, siginfo_t *info, void *context)
+{
+    for (size_t i = 0; i < RK_ARENA_MAX_COLD_ARENAS; i++)
+    {
+        rkArena *const arena = __atomic_load_n(&rkColdArenas[i], __ATOMIC_ACQUIRE);
+        if (!arena)
+        {
+            continue;
+        }
+
+        // A fault on a writable page means that another thread warmed or
+        // spilled it after the access, which then succeeds once retried
+        rkLockTables(arena);
+        const size_t page = rkFindPage(arena, info->si_addr);
+        int handled = 0;
+        if (page != RK_ARENA_NO_PAGE)
+        {
+            const rkAllocPage *const p = &arena->pages[page];
+            handled = p->cold != RK_ARENA_COLD_HOT || (p->kind != RK_ARENA_KIND_FILE && !arena->frozen);
+            rkWarmPage(arena, page);
+        }
+        rkUnlockTables(arena);
+
+        if (handled)
+        {
+            return;
+        }
+    }
+
+    if ((rkPrevSegvAction.sa_flags & SA_SIGINFO) && rkPrevSegvAction.sa_sigaction)
+    {
+        rkPrevSegvAction.sa_sigaction(sig, info, context);
+        return;
+    }
+
+    if (rkPrevSegvAction.sa_handler != SIG_DFL && rkPrevSegvAction.sa_handler != SIG_IGN)
+    {
+        rkPrevSegvAction.sa_handler(sig);
+        return;
+    }
+
+    // Returning retries the access, which now takes the default action
+    signal(sig, SIG_DFL);
+}
+#endif /* RK_ARENA_PLATFORM_LINUX */
+
+static void rkWarmPage(rkArena *arena, size_t page)
+{
+    rkAllocPage *const p = &arena->pages[page];
+    if (p->cold == RK_ARENA_COLD_HOT)
+    {
+        return;
+    }
+
+    if (p->cold == RK_ARENA_COLD_ARMED)
+    {
+        rkProtectPage(p, 1);
+        p->cold = RK_ARENA_COLD_HOT;
+        return;
+    }
+
+#if defined(RK_ARENA_PLATFORM_LINUX) && defined(SYS_mremap)
+    uint8_t *const staging = (uint8_t *)mmap(NULL, p->mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (staging != MAP_FAILED)
+    {
+        const int ok = rkLzDecompress(p->packed, p->packedSize, staging, p->packedSpan);
+        RK_ARENA_ASSERT(ok, "Corrupt compressed page: %p", (void *)p->region);
+        (void)ok;
+
+        if ((void *)syscall(SYS_mremap, staging, p->mapped, p->mapped, RK_ARENA_MREMAP_MAYMOVE | RK_ARENA_MREMAP_FIXED, p->base) != MAP_FAILED)
+        {
+            rkApplyNumaPolicy(arena, p->base, p->mapped, 0);
+            rkApplyForkPolicy(arena, p->base, p->mapped);
+            p->cold = RK_ARENA_COLD_HOT;
+            return;
+        }
+
+        munmap(staging, p->mapped);
+    }
+#endif /* RK_ARENA_PLATFORM_LINUX */
+
+    // Without a staging mapping the page is restored in place, which other
+    // threads may observe half done
+    rkProtectPage(p, 1);
+    const int ok = rkLzDecompress(p->packed, p->packedSize, p->base, p->packedSpan);
+    RK_ARENA_ASSERT(ok, "Corrupt compressed page: %p", (void *)p->region);
+    (void)ok;
+
+    p->cold = RK_ARENA_COLD_HOT;
+}
+
+static void rkDropPacked(rkArena *arena, size_t page)
+{
+    rkAllocPage *const p = &arena->pages[page];
+    if (p->cold == RK_ARENA_COLD_HOT && p->packed)
+    {
+        free(p->packed);
+        p->packed = NULL;
+        p->packedSize = 0;
+    }
+}
+
+static void rkHeatPage(rkArena *arena, size_t page)
+{
+    rkLockTables(arena);
+    rkWarmPage(arena, page);
+    rkDropPacked(arena, page);
+    rkUnlockTables(arena);
+}
+
+static void rkWarmRange(rkArena *arena, const void *ptr, size_t numBytes)
+{
+    if (!(arena->flags & RK_ARENA_FLAG_COMPRESS))
+    {
+        return;
+    }
+
+    const uint8_t *cursor = (const uint8_t *)ptr;
+    const uint8_t *const end = cursor + numBytes;
+    while (cursor < end)
+    {
+        const size_t page = rkFindPage(arena, cursor);
+        if (page == RK_ARENA_NO_PAGE)
+        {
+            return;
+        }
+
+        rkHeatPage(arena, page);
+        cursor = arena->pages[page].region + arena->pages[page].size;
+    }
+}
+
+static void rkWarmArena(rkArena *arena)
+{
+    if (!(arena->flags & RK_ARENA_FLAG_COMPRESS))
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < arena->numPages; i++)
+    {
+        if (arena->pages[i].owner != RK_ARENA_PAGE_UNUSED)
+        {
+            rkHeatPage(arena, i);
+        }
+    }
+}
+
+static void rkDiscardCold(rkArena *arena, size_t page)
+{
+    rkLockTables(arena);
+    rkAllocPage *const p = &arena->pages[page];
+    if (p->cold != RK_ARENA_COLD_HOT)
+    {
+        rkProtectPage(p, 1);
+        p->cold = RK_ARENA_COLD_HOT;
+    }
+
+    rkDropPacked(arena, page);
+    rkUnlockTables(arena);
+}
+
+static size_t rkPackPage(rkArena *arena, size_t page)
+{
+    rkAllocPage *const p = &arena->pages[page];
+    const size_t used = (size_t)(p->region + p->offset - p->base);
+    const size_t capacity = used - used / 4;
+
+    uint8_t *const packed = (uint8_t *)malloc(capacity);
+    size_t packedSize = 0;
+#if defined(RK_ARENA_PLATFORM_LINUX)
+    if (packed && mprotect(p->base, p->mapped, PROT_READ) == 0)
+    {
+        packedSize = rkLzCompress(p->base, used, packed, capacity);
+    }
+#endif /* RK_ARENA_PLATFORM_LINUX */
+
+    if (packedSize == 0)
+    {
+        free(packed);
+        rkProtectPage(p, 1);
+        p->cold = RK_ARENA_COLD_HOT;
+        return 0;
+    }
+
+#if defined(RK_ARENA_PLATFORM_LINUX)
+    // The mapping stays inaccessible, and reads back as zeroes once released
+    mprotect(p->base, p->mapped, PROT_NONE);
+    madvise(p->base, p->mapped, MADV_DONTNEED);
+#endif /* RK_ARENA_PLATFORM_LINUX */
+
+    uint8_t *const shrunk = (uint8_t *)realloc(packed, packedSize);
+    p->packed = shrunk ? shrunk : packed;
+    p->packedSize = packedSize;
+    p->packedSpan = used;
+    p->cold = RK_ARENA_COLD_PACKED;
+
+    return used - packedSize;
+}
+
+static size_t rkLzCompress(const uint8_t *src, size_t n, uint8_t *dst, size_t capacity)
+{
+    size_t table[1 << RK_ARENA_LZ_HASH_BITS];
+    memset(table, 0, sizeof(table));
+
+    size_t out = 0;
+    size_t anchor = 0;
+    size_t i = 0;
+    while (i + RK_ARENA_LZ_MIN_MATCH <= n)
+    {
+        uint32_t word;
+        memcpy(&word, src + i, sizeof(word));
+        const size_t hash = (uint32_t)(word * 2654435761u) >> (32 - RK_ARENA_LZ_HASH_BITS);
+
+        // Positions are stored plus one, so that zero marks an empty entry
+        const size_t candidate = table[hash];
+        table[hash] = i + 1;
+        if (candidate == 0 || i - (candidate - 1) > RK_ARENA_LZ_MAX_OFFSET || memcmp(src + candidate - 1, src + i, RK_ARENA_LZ_MIN_MATCH) != 0)
+        {
+            i++;
+            continue;
+        }
+
+        const size_t match = candidate - 1;
+        size_t length = RK_ARENA_LZ_MIN_MATCH;
+        while (i + length < n && src[match + length] == src[i + length])
+        {
+            length++;
+        }
+
+        if (!rkLzEmit(dst, capacity, &out, src + anchor, i - anchor, i - match, length))
+        {
+            return 0;
+        }
+
+        i += length;
+        anchor = i;
+    }
+
+    if (!rkLzEmit(dst, capacity, &out, src + anchor, n - anchor, 0, 0))
+    {
+        return 0;
+    }
+
+    return out;
+}
+
+static int rkLzEmit(uint8_t *dst, size_t capacity, size_t *out, const uint8_t *literals, size_t numLiterals, size_t offset, size_t matchLength)
+{
+    // A token holds the short lengths, longer ones continue in bytes of 255
+    const size_t extra = matchLength ? matchLength - RK_ARENA_LZ_MIN_MATCH : 0;
+    const size_t worst = 1 + numLiterals / 255 + 1 + numLiterals + 2 + extra / 255 + 1;
+    size_t o = *out;
+    if (worst > capacity - o)
+    {
+        return 0;
+    }
+
+    uint8_t *const token = &dst[o++];
+    *token = (uint8_t)((numLiterals < 15 ? numLiterals : 15) << 4);
+    if (numLiterals >= 15)
+    {
+        size_t rest = numLiterals - 15;
+        for (; rest >= 255; rest -= 255)
+        {
+            dst[o++] = 255;
+        }
+        dst[o++] = (uint8_t)rest;
+    }
+
+    memcpy(dst + o, literals, numLiterals);
+    o += numLiterals;
+
+    if (matchLength)
+    {
+        dst[o++] = (uint8_t)(offset & 0xFF);
+        dst[o++] = (uint8_t)(offset >> 8);
+        *token |= (uint8_t)(extra < 15 ? extra : 15);
+        if (extra >= 15)
+        {
+            size_t rest = extra - 15;
+            for (; rest >= 255; rest -= 255)
+            {
+                dst[o++] = 255;
+            }
+            dst[o++] = (uint8_t)rest;
+        }
+    }
+
+    *out = o;
+    return 1;
+}
+
+static int rkLzDecompress(const uint8_t *src, size_t n, uint8_t *dst, size_t size)
+{
+    size_t ip = 0;
+    size_t op = 0;
+    while (ip < n)
+    {
+        const unsigned token = src[ip++];
+        size_t numLiterals = token >> 4;
+        if (numLiterals == 15)
+        {
+            unsigned byte = 255;
+            while (byte == 255)
+            {
+                if (ip == n)
+                {
+                    return 0;
+                }
+
+                byte = src[ip++];
+                numLiterals += byte;
+            }
+        }
+
+        if (numLiterals > n - ip || numLiterals > size - op)
+        {
+            return 0;
+        }
+
+        memcpy(dst + op, src + ip, numLiterals);
+        ip += numLiterals;
+        op += numLiterals;
+        if (ip == n)
+        {
+            break;
+        }
+
+        if (n - ip < 2)
+        {
+            return 0;
+        }
+
+        const size_t offset = (size_t)src[ip] | ((size_t)src[ip + 1] << 8);
+        ip += 2;
+
+        size_t length = (token & 15) + RK_ARENA_LZ_MIN_MATCH;
+        if ((token & 15) == 15)
+        {
+            unsigned byte = 255;
+            while (byte == 255)
+            {
+                if (ip == n)
+                {
+                    return 0;
+                }
+
+                byte = src[ip++];
+                length += byte;
+            }
+        }
+
+        if (offset == 0 || offset > op || length > size - op)
+        {
+            return 0;
+        }
+
+        // Matches may overlap their own output, so they are copied bytewise
+        for (size_t k = 0; k < length; k++, op++)
+        {
+            dst[op] = dst[op - offset];
+        }
+    }
+
+    return op == size;
+}
+
+static void rkEnforceBudget(rkArena *arena)
+{
+    // Spilling maps the pages writable, which would thaw a frozen arena
+    if (arena->residentBytes <= arena->spillBudget || arena->frozen)
+    {
+        return;
+    }
+
+    // Cached pages hold nothing, so they go first
+    const size_t excess = arena->residentBytes - arena->spillBudget;
+    const size_t cached = arena->cachedBytes;
+    rkArenaTrim(arena, cached > excess ? cached - excess : 0);
+
+    // Only the current pages and the page mapped last are passed over, so
+    // every call looks at a bounded number of pages beyond those it spills
+    size_t page = arena->lruHead;
+    while (page != RK_ARENA_NO_PAGE && arena->residentBytes > arena->spillBudget)
+    {
+        const rkAllocPage *const p = &arena->pages[page];
+        const size_t next = p->lruNext;
+        if (page == arena->chains[p->owner].curr || p->lastUse == arena->clock)
+        {
+            page = next;
+            continue;
+        }
+
+        rkHeatPage(arena, page);
+        if (!rkSpillPage(arena, page))
+        {
+            return;
+        }
+
+        page = next;
+    }
+}
+
+static int rkSpillPage(rkArena *arena, size_t page)
+{
+#if defined(RK_ARENA_PLATFORM_LINUX)
+    rkAllocPage *const p = &arena->pages[page];
+    const size_t offset = arena->spillEnd;
+
+    // Other threads may write to a page of a compressed arena, so the page is
+    // made read-only until the file replaces it. Their writes fault and wait
+    // on the lock, and are retried on the file once the page is spilled
+    const int shared = (arena->flags & RK_ARENA_FLAG_COMPRESS) != 0;
+    rkLockTables(arena);
+    if (shared && mprotect(p->base, p->mapped, PROT_READ) != 0)
+    {
+        rkUnlockTables(arena);
+        return 0;
+    }
+
+    for (size_t done = 0; done < p->mapped; )
+    {
+        const ssize_t n = pwrite(arena->spillFd, p->base + done, p->mapped - done, (off_t)(offset + done));
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (n <= 0)
+        {
+            if (shared)
+            {
+                mprotect(p->base, p->mapped, PROT_READ | PROT_WRITE);
+            }
+
+            rkUnlockTables(arena);
+            return 0;
+        }
 
-/**
- * An operating system agnostic memory request function. This simply performs
- * a syscall to request memory from the kernel
- *
- * @param[in] numBytes
- *      The number of bytes to allocate
- *
- * @return
- *      A pointer to the newly allocated memory, or `NULL` upon failure
- */
-static void *rkOsMalloc(size_t numBytes);
+        done += (size_t)n;
+    }
 
-/**
- * Frees the memory allocated at `ptr` by use of an operating system syscall
- *
- * @param[in] ptr
- *      A pointer to the memory to deallocate
- * @param[in] numBytes
- *      The number of bytes to deallocate
- */
-static void rkOsFree(void *ptr, size_t numBytes);
+    // Mapping the file over the page swaps the backing store without moving
+    // the page or changing its contents
+    void *const ptr = mmap(p->base, p->mapped, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, arena->spillFd, (off_t)offset);
+    if (ptr == MAP_FAILED)
+    {
+        if (shared)
+        {
+            mprotect(p->base, p->mapped, PROT_READ | PROT_WRITE);
+        }
 
-#if defined(RK_ARENA_DEBUG)
-/**
- * This is just a show stopper for is something horribly goes wrong
- */
-static void rkArenaPanic(const char *fmt, ...);
-#endif
+        rkUnlockTables(arena);
+        return 0;
+    }
 
-// --- arena interface --------------------------------------------------------
+    p->kind = RK_ARENA_KIND_SPILLED;
+    rkUnlockTables(arena);
 
-rkArena *rkCreateArena(void)
-{
-    return rkNewArena(DEFAULT_PAGE_SIZE);
+    madvise(p->base, p->mapped, RK_ARENA_MADV_COLD);
+    rkApplyForkPolicy(arena, p->base, p->mapped);
+
+    rkUnqueuePage(arena, page);
+    arena->residentBytes -= p->mapped;
+    p->spillOffset = offset;
+    arena->spillEnd += p->mapped;
+    arena->numSpilled++;
+    return 1;
+#else
+    (void)arena;
+    (void)page;
+    return 0;
+#endif /* RK_ARENA_PLATFORM_LINUX */
 }
 
-rkArena *rkCreateArenaWithPageSize(size_t pageSize)
+static void rkReleaseSpill(rkArena *arena, const rkAllocPage *page)
 {
-    return rkNewArena(pageSize);
+#if defined(RK_ARENA_PLATFORM_LINUX)
+    arena->numSpilled--;
+    if (arena->numSpilled == 0)
+    {
+        arena->spillEnd = 0;
+        if (ftruncate(arena->spillFd, 0) == 0)
+        {
+            return;
+        }
+    }
+
+#if defined(SYS_fallocate)
+    syscall(SYS_fallocate, arena->spillFd, RK_ARENA_FALLOC_FL_PUNCH_HOLE | RK_ARENA_FALLOC_FL_KEEP_SIZE, (off_t)page->spillOffset, (off_t)page->mapped);
+#endif /* SYS_fallocate */
+#else
+    (void)arena;
+    (void)page;
+#endif /* RK_ARENA_PLATFORM_LINUX */
 }
 
-void rkFreeArena(rkArena *arena)
+static long rkReadCounter(const char *path)
 {
-    RK_ARENA_ASSERT(arena != NULL, "Cannot free a NULL arena");
-
-    rkAllocPage *p = arena->curr;
-    while (p)
+    FILE *const file = fopen(path, "r");
+    if (!file)
     {
-        rkAllocPage *const q = p->next;
+        return -1;
+    }
 
-        rkOsFree(p, sizeof(rkAllocPage) + sizeof(uint8_t) * p->size);
-        p = q;
+    long counter = -1;
+    if (fscanf(file, "%ld", &counter) != 1)
+    {
+        counter = -1;
     }
 
-    rkOsFree(arena, sizeof(rkArena));
+    fclose(file);
+    return counter;
 }
 
-void rkResetArena(rkArena *arena)
+static int rkReadNumaNodes(unsigned long *mask)
 {
-    RK_ARENA_ASSERT(arena != NULL, "Cannot reset a NULL arena");
-    for (rkAllocPage *p = arena->curr; p; p = p->next)
+    FILE *const file = fopen(rkNumaOnlinePath, "r");
+    if (!file)
     {
-        p->offset = 0;
+        if (mask)
+        {
+            mask[0] |= 1UL;
+        }
+
+        return 1;
     }
-}
 
-void *rkArenaAlloc(rkArena *arena, size_t numBytes)
-{
-    RK_ARENA_ASSERT(arena != NULL, "Cannot allocate from NULL arena");
+    int count = 0;
+    unsigned lo = 0;
+    unsigned hi = 0;
+    int sep = 0;
+    while (fscanf(file, "%u", &lo) == 1)
+    {
+        hi = lo;
+        sep = fgetc(file);
+        if (sep == '-')
+        {
+            if (fscanf(file, "%u", &hi) != 1)
+            {
+                break;
+            }
 
-    rkAllocPage *const currPage = arena->curr;
-    if (currPage->offset + numBytes > currPage->size)
+            sep = fgetc(file);
+        }
+
+        for (unsigned n = lo; n <= hi && n < RK_ARENA_MAX_NUMA_NODES; n++)
+        {
+            if (mask)
+            {
+                mask[n / RK_ARENA_NUMA_MASK_BITS] |= 1UL << (n % RK_ARENA_NUMA_MASK_BITS);
+            }
+
+            count++;
+        }
+
+        if (sep != ',')
+        {
+            break;
+        }
+    }
+
+    fclose(file);
+    if (count == 0)
     {
-        rkAllocPage *const newPage = rkNewPage(arena->pageSize, currPage);
-        if (!newPage)
+        if (mask)
         {
-            return NULL;
+            mask[0] |= 1UL;
         }
-        else
+
+        return 1;
+    }
+
+    return count;
+}
+
+inline static void *rkAllocFromPage(rkAllocPage *page, size_t numBytes)
+{
+    RK_ARENA_ASSERT(numBytes > 0, "Cannot allocate zero bytes");
+    RK_ARENA_ASSERT(numBytes <= page->size, "Cannot allocate %zu bytes from a page size of %zu bytes", numBytes, page->size);
+
+    void *const ptr = (void *)(page->region + page->offset);
+    page->offset += numBytes;
+    page->live++;
+
+    return ptr;
+}
+
+static void rkPrefetchAhead(const rkAllocPage *page, const uint8_t *ptr)
+{
+    uint8_t *const cursor = page->region + page->offset;
+    uint8_t *const end = page->region + page->size;
+
+    for (size_t i = 0; i < RK_ARENA_PREFETCH_LINES; i++)
+    {
+        uint8_t *const line = cursor + i * RK_ARENA_CACHE_LINE;
+        if (line >= end)
         {
-            arena->curr = newPage;
+            break;
         }
 
-        return rkAllocFromPage(newPage, numBytes);
-    } 
+        RK_ARENA_PREFETCHW(line);
+    }
+
+    // The threshold of an OS page lies `RK_ARENA_TOUCH_THRESHOLD` bytes into
+    // it, so only touch when this allocation is the one that moved past it
+    const uintptr_t before = (uintptr_t)ptr - RK_ARENA_TOUCH_THRESHOLD;
+    const uintptr_t after = (uintptr_t)cursor - RK_ARENA_TOUCH_THRESHOLD;
+    if (before / RK_ARENA_OS_PAGE_SIZE == after / RK_ARENA_OS_PAGE_SIZE)
+    {
+        return;
+    }
 
-    return rkAllocFromPage(currPage, numBytes);
+    volatile uint8_t *const next = (volatile uint8_t *)((after / RK_ARENA_OS_PAGE_SIZE + 1) * RK_ARENA_OS_PAGE_SIZE);
+    if ((uint8_t *)next < end)
+    {
+        // Rewrite whatever is there, so that the page is faulted in for
+        // writing without changing its contents
+        *next = *next;
+    }
 }
 
-void *rkArenaAllocZeroed(rkArena *arena, size_t numBytes)
+static void *rkAllocFromTails(rkArena *arena, rkPageChain *chain, size_t numBytes)
 {
-    RK_ARENA_ASSERT(arena != NULL, "Cannot allocate from NULL arena");
+    size_t i = 0;
+    while (i < chain->numTails && rkPageFree(arena, chain->tails[i]) < numBytes)
+    {
+        i++;
+    }
 
-    void *const ptr = rkArenaAlloc(arena, numBytes);
-    if (!ptr)
+    if (i == chain->numTails)
     {
         return NULL;
     }
 
-    memset(ptr, 0x00, numBytes);
+    const size_t page = chain->tails[i];
+    void *const ptr = rkAllocFromPage(&arena->pages[page], numBytes);
+    rkTouchPage(arena, page);
+    arena->tailReused += numBytes;
+
+    // The tail only shrank, so it moves towards the front of the list
+    const size_t free = rkPageFree(arena, page);
+    if (free < RK_ARENA_MIN_TAIL)
+    {
+        memmove(&chain->tails[i], &chain->tails[i + 1], (chain->numTails - i - 1) * sizeof(size_t));
+        chain->numTails--;
+        return ptr;
+    }
+
+    while (i > 0 && rkPageFree(arena, chain->tails[i - 1]) > free)
+    {
+        chain->tails[i] = chain->tails[i - 1];
+        i--;
+    }
+    chain->tails[i] = page;
+
     return ptr;
 }
 
-void *rkArenaRealloc(rkArena *arena, void *ptr, size_t oldSize, size_t newSize)
+static void *rkAllocLarge(rkArena *arena, rkArenaHint hint, size_t numBytes)
 {
-    RK_ARENA_ASSERT(arena != NULL, "Cannot reallocate from NULL arena");
-    RK_ARENA_ASSERT(ptr != NULL, "Cannot reallocate a NULL pointer");
-    RK_ARENA_ASSERT(oldSize <= newSize, "oldSize cannot be greater than newSize");
+    const size_t page = rkMapPage(arena, numBytes, (unsigned)hint);
+    if (page == RK_ARENA_NO_PAGE)
+    {
+        return NULL;
+    }
 
-    uint8_t *const newBytes = (uint8_t *)rkArenaAlloc(arena, newSize);
-    if (!newBytes)
+    return rkAllocFromPage(&arena->pages[page], numBytes);
+}
+
+static void *rkIngest(rkArena *arena, int fd, size_t maxBytes, int recvFlags, size_t *numRead)
+{
+    *numRead = 0;
+    if (arena->frozen || maxBytes == 0 || maxBytes > SIZE_MAX - RK_ARENA_DIRECT_BLOCK)
     {
         return NULL;
     }
 
-    const uint8_t *const oldBytes = (uint8_t *)ptr;
-    for (size_t i = 0; i < oldSize; i++)
+    if (arena->flags & RK_ARENA_FLAG_DIRECT_IO)
     {
-        newBytes[i] = oldBytes[i];
+        maxBytes = (maxBytes + RK_ARENA_DIRECT_BLOCK - 1) & ~(size_t)(RK_ARENA_DIRECT_BLOCK - 1);
     }
 
-    return (void *)newBytes;
+    rkPageChain *const chain = &arena->chains[RK_NORMAL];
+    const int dedicated = maxBytes > arena->pageSize;
+    size_t page = chain->curr;
+    if (dedicated)
+    {
+        page = rkMapPage(arena, maxBytes, RK_NORMAL);
+    }
+    else if (page == RK_ARENA_NO_PAGE || rkPageFree(arena, page) < maxBytes)
+    {
+        page = rkObtainPage(arena, RK_NORMAL);
+        if (page != RK_ARENA_NO_PAGE)
+        {
+            if (chain->curr != RK_ARENA_NO_PAGE)
+            {
+                rkRetirePage(arena, chain, chain->curr);
+            }
+
+            chain->curr = page;
+        }
+    }
+
+    if (page == RK_ARENA_NO_PAGE)
+    {
+        return NULL;
+    }
+
+    rkHeatPage(arena, page);
+
+    rkAllocPage *const p = &arena->pages[page];
+    uint8_t *const ptr = p->region + p->offset;
+#if defined(RK_ARENA_PLATFORM_LINUX)
+    ssize_t n = -1;
+    do
+    {
+        n = recvFlags < 0 ? read(fd, ptr, maxBytes) : recv(fd, ptr, maxBytes, recvFlags);
+    } while (n < 0 && errno == EINTR);
+#elif defined(RK_ARENA_PLATFORM_WINDOWS)
+    const int n = recvFlags < 0 ? _read(fd, ptr, maxBytes > INT_MAX ? INT_MAX : (unsigned)maxBytes) : -1;
+#else
+    const int n = -1;
+    (void)fd;
+#endif /* RK_ARENA_PLATFORM_XXX */
+
+    if (n < 0)
+    {
+        if (dedicated)
+        {
+            rkUnmapPage(arena, page);
+        }
+
+        return NULL;
+    }
+
+    size_t committed = (size_t)n;
+    if (arena->flags & RK_ARENA_FLAG_DIRECT_IO)
+    {
+        committed = (committed + RK_ARENA_DIRECT_BLOCK - 1) & ~(size_t)(RK_ARENA_DIRECT_BLOCK - 1);
+    }
+
+    p->offset += committed;
+    p->live += n > 0;
+    if (dedicated)
+    {
+        // Whatever the read left of the dedicated page serves later requests
+        rkRetirePage(arena, chain, page);
+    }
+
+    *numRead = (size_t)n;
+    return (void *)ptr;
 }
 
-void rkDebugArena(const rkArena *arena)
+static void rkRetirePage(rkArena *arena, rkPageChain *chain, size_t page)
 {
-    if (!arena)
+    rkTouchPage(arena, page);
+
+    const size_t free = rkPageFree(arena, page);
+    if (free < RK_ARENA_MIN_TAIL)
     {
-        printf("Arena { NULL }\n");
         return;
     }
 
-    printf("Arena {\n");
-    printf("\tpageSize=%zu\n", arena->pageSize);
-    printf("\tcurr=");
-    
-    rkAllocPage *p = arena->curr;
-    while (p)
+    if (chain->numTails == RK_ARENA_MAX_TAILS)
+    {
+        if (rkPageFree(arena, chain->tails[0]) >= free)
+        {
+            return;
+        }
+
+        memmove(&chain->tails[0], &chain->tails[1], (RK_ARENA_MAX_TAILS - 1) * sizeof(size_t));
+        chain->numTails--;
+    }
+
+    size_t i = chain->numTails++;
+    while (i > 0 && rkPageFree(arena, chain->tails[i - 1]) > free)
     {
-        printf("AllocPage { region=%p, offset=%zu, size=%zu } -> ", (void *)p->region, p->offset, p->size);
-        p = p->next;
+        chain->tails[i] = chain->tails[i - 1];
+        i--;
     }
-    printf("NULL\n");
-    printf("}\n");
+    chain->tails[i] = page;
 }
 
-// --- utility functions ------------------------------------------------------
-
-static rkArena *rkNewArena(size_t pageSize)
+static void *rkRemapLarge(rkArena *arena, void *ptr, size_t newSize)
 {
-    rkArena *const arena = (rkArena *)rkOsMalloc(sizeof(rkArena));
-    if (!arena)
+#if defined(RK_ARENA_PLATFORM_LINUX) && defined(SYS_mremap)
+    const size_t i = rkFindPage(arena, ptr);
+    if (i == RK_ARENA_NO_PAGE || newSize > SIZE_MAX - 2 * RK_ARENA_OS_PAGE_SIZE)
     {
         return NULL;
     }
 
-    rkAllocPage *const page = rkNewPage(pageSize, NULL);
-    if (!page)
+    rkAllocPage *const page = &arena->pages[i];
+    if (page->owner >= RK_ARENA_HINT_COUNT || page->kind != RK_ARENA_KIND_ANON || page->region != (uint8_t *)ptr || page->size == arena->pageSize || page->offset != page->size)
     {
         return NULL;
     }
 
-    arena->pageSize = pageSize;
-    arena->curr = page;
+    rkHeatPage(arena, i);
 
-    return arena;
+    const size_t colorOffset = (size_t)(page->region - page->base);
+    const size_t newMapped = (colorOffset + newSize + RK_ARENA_OS_PAGE_SIZE - 1) & ~(size_t)(RK_ARENA_OS_PAGE_SIZE - 1);
+
+    rkUnindexPage(arena, i);
+    void *const newBase = (void *)syscall(SYS_mremap, page->base, page->mapped, newMapped, RK_ARENA_MREMAP_MAYMOVE);
+    if (newBase == MAP_FAILED)
+    {
+        rkIndexPage(arena, i);
+        return NULL;
+    }
+
+    arena->residentBytes += newMapped - page->mapped;
+    page->base = (uint8_t *)newBase;
+    page->mapped = newMapped;
+    page->region = page->base + colorOffset;
+    page->size = newSize;
+    page->offset = newSize;
+
+    rkIndexPage(arena, i);
+    rkApplyNumaPolicy(arena, newBase, newMapped, 0);
+    rkApplyForkPolicy(arena, newBase, newMapped);
+
+    // The grown block is the one in use, so other pages are spilled first
+    void *const region = (void *)page->region;
+    rkTouchPage(arena, i);
+    if (arena->spillFd >= 0)
+    {
+        rkEnforceBudget(arena);
+    }
+
+    return region;
+#else
+    (void)arena;
+    (void)ptr;
+    (void)newSize;
+#endif /* RK_ARENA_PLATFORM_LINUX */
+
+    return NULL;
 }
 
-static rkAllocPage *rkNewPage(size_t size, rkAllocPage *next)
+static void rkEmptyPage(rkArena *arena, size_t page)
 {
-    RK_ARENA_ASSERT(size > 0, "Page size cannot be zero");
+    rkDiscardCold(arena, page);
 
-    const size_t numBytes = sizeof(rkAllocPage) + sizeof(uint8_t) * size;
-    rkAllocPage *const page = (rkAllocPage *)rkOsMalloc(numBytes);
-    if (!page)
+    rkAllocPage *const p = &arena->pages[page];
+    rkPageChain *const chain = &arena->chains[p->owner];
+    if (page == chain->curr)
     {
-        return NULL;
+        p->offset = 0;
+        return;
     }
 
-    page->region = (uint8_t *)(page + 1);
-    page->offset = 0;
-    page->size = size;
-    page->next = next;
+    for (size_t i = 0; i < chain->numTails; i++)
+    {
+        if (chain->tails[i] == page)
+        {
+            memmove(&chain->tails[i], &chain->tails[i + 1], (chain->numTails - i - 1) * sizeof(size_t));
+            chain->numTails--;
+            break;
+        }
+    }
 
-    return page;
+    if (p->size != arena->pageSize || p->kind != RK_ARENA_KIND_ANON)
+    {
+        rkUnmapPage(arena, page);
+        return;
+    }
+
+    if (arena->frozen)
+    {
+        rkProtectPage(p, 1);
+    }
+
+    rkUnqueuePage(arena, page);
+    p->offset = 0;
+    p->owner = RK_ARENA_PAGE_CACHED;
+    p->next = arena->cache;
+    arena->cache = page;
+    arena->cachedBytes += p->size;
 }
 
-inline static void *rkAllocFromPage(rkAllocPage *page, size_t numBytes)
+static void rkResetChains(rkArena *arena, unsigned first, unsigned last)
 {
-    RK_ARENA_ASSERT(numBytes > 0, "Cannot allocate zero bytes");
-    RK_ARENA_ASSERT(numBytes <= page->size, "Cannot allocate %zu bytes from a page size of %zu bytes", numBytes, page->size);
+    for (size_t i = 0; i < arena->numPages; i++)
+    {
+        rkAllocPage *const page = &arena->pages[i];
+        if (page->owner < first || page->owner >= last)
+        {
+            continue;
+        }
 
-    void *const ptr = (void *)(page->region + page->offset);
-    page->offset += numBytes;
+        rkDiscardCold(arena, i);
+        page->offset = 0;
+        page->live = 0;
+        if (i == arena->chains[page->owner].curr)
+        {
+            continue;
+        }
 
-    return ptr;
+        if (page->size != arena->pageSize || page->kind != RK_ARENA_KIND_ANON)
+        {
+            rkUnmapPage(arena, i);
+            continue;
+        }
+
+        rkUnqueuePage(arena, i);
+        page->owner = RK_ARENA_PAGE_CACHED;
+        page->next = arena->cache;
+        arena->cache = i;
+        arena->cachedBytes += page->size;
+    }
+
+    for (unsigned h = first; h < last; h++)
+    {
+        arena->chains[h].numTails = 0;
+    }
+}
+
+static void rkPrewarmArena(rkArena *arena, size_t numPages)
+{
+    const rkAllocPage *const curr = &arena->pages[arena->chains[RK_NORMAL].curr];
+    for (size_t i = 0; i < curr->size; i += RK_ARENA_OS_PAGE_SIZE)
+    {
+        curr->region[i] = 0;
+    }
+
+    for (size_t n = 1; n < numPages; n++)
+    {
+        // Mapping may move the page table, so the descriptor is looked up
+        // only afterwards
+        const size_t i = rkMapPage(arena, arena->pageSize, RK_ARENA_PAGE_CACHED);
+        if (i == RK_ARENA_NO_PAGE)
+        {
+            return;
+        }
+
+        rkAllocPage *const page = &arena->pages[i];
+        for (size_t j = 0; j < page->size; j += RK_ARENA_OS_PAGE_SIZE)
+        {
+            page->region[j] = 0;
+        }
+
+        page->next = arena->cache;
+        arena->cache = i;
+        arena->cachedBytes += page->size;
+    }
+}
+
+static size_t rkArenaFootprint(const rkArena *arena)
+{
+    size_t footprint = arena->cachedBytes;
+    for (size_t i = 0; i < arena->numPages; i++)
+    {
+        if (arena->pages[i].owner < RK_ARENA_HINT_COUNT)
+        {
+            footprint += arena->pages[i].size;
+        }
+    }
+
+    return footprint;
+}
+
+static size_t rkPoolShardIndex(void)
+{
+    if (rkThreadShard == 0)
+    {
+        rkThreadShard = RK_ARENA_ATOMIC_INC(&rkShardSeed) % RK_ARENA_POOL_SHARDS + 1;
+    }
+
+    return rkThreadShard - 1;
 }
 
 inline static void *rkOsMalloc(size_t numBytes)
@@ -431,9 +4516,11 @@ inline static void rkOsFree(void *ptr, size_t numBytes)
 #if defined(RK_ARENA_PLATFORM_LINUX)
     const int r = munmap(ptr, numBytes);
     RK_ARENA_ASSERT(r == 0, "Failed to deallocate pointer: %p", ptr);
+    (void)r;
 #elif defined(RK_ARENA_PLATFORM_WINDOWS)
     const BOOL r = VirtualFreeEx(GetCurrentProcess(), ptr, numBytes, MEM_RELEASE);
     RK_ARENA_ASSERT(r == FALSE, "Failed to deallocate pointer: %p", ptr);
+    (void)r;
 #elif defined(RK_ARENA_PLATFORM_APPLE)
 #    error "Unimplemented: I don't own an apple device to test this with"
 #else
@@ -0,0 +1,383 @@
+#ifndef RK_BUFFER_H
+#define RK_BUFFER_H
+
+#include <stddef.h>
+
+// --- type definitions -------------------------------------------------------
+
+// Handle to a pool of refcounted buffer pages
+typedef struct rkBufferPool rkBufferPool;
+
+/**
+ * A reference to a slice of a buffer page. Slices are passed around by value,
+ * and every copy that is kept has to be accounted for with `rkBufferRetain`
+ */
+typedef struct rkBufferSlice
+{
+    unsigned char        *data; // The start of the slice
+    size_t                size; // The size of the slice in bytes
+    struct rkBufferPage  *page; // The page the slice was carved from
+} rkBufferSlice;
+
+/**
+ * A snapshot of the state of a buffer pool
+ */
+typedef struct rkBufferPoolStats
+{
+    size_t pageCount;     // The number of pages owned by the pool, including free ones
+    size_t freePageCount; // The number of pages waiting to be reused
+    size_t recycledPages; // The number of times a page was reused
+} rkBufferPoolStats;
+
+// --- buffer interface -------------------------------------------------------
+
+/**
+ * Creates a pool of buffer pages. Slices are bump allocated from the current
+ * page, and a page is recycled as a whole once every slice referencing it
+ * has been released
+ *
+ * @param[in] pageSize
+ *      The capacity of the pages in bytes
+ *
+ * @return
+ *      A pointer to the newly created pool, or `NULL` upon failure
+ */
+rkBufferPool *rkCreateBufferPool(size_t pageSize);
+
+/**
+ * Frees the pool and its pages. Every slice has to be released beforehand
+ *
+ * @param[in] pool
+ *      A pointer to the pool to deallocate
+ */
+void rkFreeBufferPool(rkBufferPool *pool);
+
+/**
+ * Allocates a slice of `numBytes` bytes holding a single reference. Slices
+ * larger than the page size get a dedicated page that is freed instead of
+ * recycled. Only one thread may allocate from a pool at a time
+ *
+ * @param[in] pool
+ *      A pointer to the pool to allocate from
+ * @param[in] numBytes
+ *      The size of the slice in bytes
+ *
+ * @return
+ *      The slice, whose `data` is `NULL` upon failure
+ */
+rkBufferSlice rkBufferAlloc(rkBufferPool *pool, size_t numBytes);
+
+/**
+ * Adds a reference to the page of `slice`, e.g. for every subscriber a
+ * message is fanned out to. This function is thread-safe
+ *
+ * @param[in] slice
+ *      The slice to retain
+ *
+ * @return
+ *      The same slice
+ */
+rkBufferSlice rkBufferRetain(rkBufferSlice slice);
+
+/**
+ * Creates a retained slice of `numBytes` bytes at `offset` into `slice`,
+ * sharing its page. This function is thread-safe
+ *
+ * @param[in] slice
+ *      The slice to take a part of
+ * @param[in] offset
+ *      The offset into `slice` in bytes
+ * @param[in] numBytes
+ *      The size of the new slice in bytes
+ *
+ * @return
+ *      The new slice
+ */
+rkBufferSlice rkBufferSubSlice(rkBufferSlice slice, size_t offset, size_t numBytes);
+
+/**
+ * Drops a reference to the page of `slice`. The page is recycled once its
+ * last reference is dropped and it is no longer being allocated from. This
+ * function is thread-safe
+ *
+ * @param[in] slice
+ *      The slice to release
+ */
+void rkBufferRelease(rkBufferSlice slice);
+
+/**
+ * Collects the state of the pool
+ *
+ * @param[in] pool
+ *      A pointer to the pool
+ * @param[out] stats
+ *      The stats to populate
+ */
+void rkBufferPoolGetStats(rkBufferPool *pool, rkBufferPoolStats *stats);
+
+#if defined(RK_BUFFER_IMPLEMENTATION)
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- platform defines -------------------------------------------------------
+
+#if defined(_WIN32) || defined(_WIN64)
+#    error "Unimplemented: the buffer pool needs GCC style atomics"
+#endif /* platform detection */
+
+// --- constants --------------------------------------------------------------
+
+// Slices start on this boundary, so that they can hold any message struct
+#define RK_BUFFER_ALIGNMENT 16
+
+// --- macros -----------------------------------------------------------------
+
+#define RK_BUFFER_ADD(ptr, v) __atomic_add_fetch((ptr), (v), __ATOMIC_RELAXED)
+#define RK_BUFFER_SUB(ptr, v) __atomic_sub_fetch((ptr), (v), __ATOMIC_ACQ_REL)
+#define RK_BUFFER_SPIN_LOCK(ptr) while (__atomic_exchange_n((ptr), 1, __ATOMIC_ACQUIRE)) \
+    while (__atomic_load_n((ptr), __ATOMIC_RELAXED))
+#define RK_BUFFER_SPIN_UNLOCK(ptr) __atomic_store_n((ptr), 0, __ATOMIC_RELEASE)
+
+// --- type definitions -------------------------------------------------------
+
+/**
+ * This struct defines a buffer page. The current page holds one reference of
+ * its own, so that it is not recycled while slices are still carved from it
+ */
+typedef struct rkBufferPage
+{
+    size_t               refs;   // The number of references to the page
+    size_t               offset; // The current offset into the data
+    size_t               size;   // The capacity of the data
+    struct rkBufferPool *pool;   // The owning pool
+    struct rkBufferPage *next;   // The next page in the free list
+    size_t               pad;    // Keeps the data aligned
+    unsigned char        data[];
+} rkBufferPage;
+
+/**
+ * This struct defines the buffer pool
+ */
+typedef struct rkBufferPool
+{
+    size_t        pageSize;  // The capacity of the pages
+    rkBufferPage *curr;      // The page slices are carved from
+    long          lock;      // The spin lock guarding the free list
+    rkBufferPage *freePages; // Pages whose slices were all released
+    size_t        numPages;  // The number of regular pages owned by the pool
+    size_t        numFree;   // The number of free pages
+    size_t        recycled;  // The number of page reuses
+} rkBufferPool;
+
+// --- function prototypes ----------------------------------------------------
+
+/**
+ * Takes a free page from the pool, or allocates a new one
+ *
+ * @return
+ *      The page holding the reference of the current page, or `NULL` upon
+ *      failure
+ */
+static rkBufferPage *rkBufferObtainPage(rkBufferPool *pool);
+
+/**
+ * Returns a page whose last reference was dropped to the free list, or frees
+ * it if it is a dedicated page
+ */
+static void rkBufferRecyclePage(rkBufferPage *page);
+
+// --- buffer interface -------------------------------------------------------
+
+rkBufferPool *rkCreateBufferPool(size_t pageSize)
+{
+    if (pageSize == 0)
+    {
+        return NULL;
+    }
+
+    rkBufferPool *const pool = (rkBufferPool *)calloc(1, sizeof(rkBufferPool));
+    if (!pool)
+    {
+        return NULL;
+    }
+
+    pool->pageSize = (pageSize + RK_BUFFER_ALIGNMENT - 1) & ~(size_t)(RK_BUFFER_ALIGNMENT - 1);
+    return pool;
+}
+
+void rkFreeBufferPool(rkBufferPool *pool)
+{
+    if (!pool)
+    {
+        return;
+    }
+
+    free(pool->curr);
+
+    rkBufferPage *page = pool->freePages;
+    while (page)
+    {
+        rkBufferPage *const next = page->next;
+        free(page);
+        page = next;
+    }
+
+    free(pool);
+}
+
+rkBufferSlice rkBufferAlloc(rkBufferPool *pool, size_t numBytes)
+{
+    rkBufferSlice slice = { NULL, 0, NULL };
+    const size_t aligned = (numBytes + RK_BUFFER_ALIGNMENT - 1) & ~(size_t)(RK_BUFFER_ALIGNMENT - 1);
+    if (numBytes == 0 || aligned < numBytes)
+    {
+        return slice;
+    }
+
+    if (aligned > pool->pageSize)
+    {
+        rkBufferPage *const page = (rkBufferPage *)malloc(sizeof(rkBufferPage) + aligned);
+        if (!page)
+        {
+            return slice;
+        }
+
+        page->refs = 1;
+        page->offset = aligned;
+        page->size = aligned;
+        page->pool = pool;
+        page->next = NULL;
+
+        slice.data = page->data;
+        slice.size = numBytes;
+        slice.page = page;
+        return slice;
+    }
+
+    rkBufferPage *page = pool->curr;
+    if (!page || page->offset + aligned > page->size)
+    {
+        rkBufferPage *const newPage = rkBufferObtainPage(pool);
+        if (!newPage)
+        {
+            return slice;
+        }
+
+        // Drop the reference of the current page, which recycles the old
+        // page right away if all of its slices were released already
+        pool->curr = newPage;
+        if (page && RK_BUFFER_SUB(&page->refs, 1) == 0)
+        {
+            rkBufferRecyclePage(page);
+        }
+
+        page = newPage;
+    }
+
+    RK_BUFFER_ADD(&page->refs, 1);
+    slice.data = page->data + page->offset;
+    slice.size = numBytes;
+    slice.page = page;
+    page->offset += aligned;
+
+    return slice;
+}
+
+rkBufferSlice rkBufferRetain(rkBufferSlice slice)
+{
+    if (slice.page)
+    {
+        RK_BUFFER_ADD(&slice.page->refs, 1);
+    }
+
+    return slice;
+}
+
+rkBufferSlice rkBufferSubSlice(rkBufferSlice slice, size_t offset, size_t numBytes)
+{
+    rkBufferSlice sub = { NULL, 0, NULL };
+    if (!slice.page || offset > slice.size || numBytes > slice.size - offset)
+    {
+        return sub;
+    }
+
+    sub.data = slice.data + offset;
+    sub.size = numBytes;
+    sub.page = slice.page;
+    return rkBufferRetain(sub);
+}
+
+void rkBufferRelease(rkBufferSlice slice)
+{
+    if (slice.page && RK_BUFFER_SUB(&slice.page->refs, 1) == 0)
+    {
+        rkBufferRecyclePage(slice.page);
+    }
+}
+
+void rkBufferPoolGetStats(rkBufferPool *pool, rkBufferPoolStats *stats)
+{
+    RK_BUFFER_SPIN_LOCK(&pool->lock);
+    stats->pageCount = pool->numPages;
+    stats->freePageCount = pool->numFree;
+    stats->recycledPages = pool->recycled;
+    RK_BUFFER_SPIN_UNLOCK(&pool->lock);
+}
+
+// --- utility functions ------------------------------------------------------
+
+static rkBufferPage *rkBufferObtainPage(rkBufferPool *pool)
+{
+    RK_BUFFER_SPIN_LOCK(&pool->lock);
+    rkBufferPage *page = pool->freePages;
+    if (page)
+    {
+        pool->freePages = page->next;
+        pool->numFree--;
+        pool->recycled++;
+    }
+    RK_BUFFER_SPIN_UNLOCK(&pool->lock);
+
+    if (!page)
+    {
+        page = (rkBufferPage *)malloc(sizeof(rkBufferPage) + pool->pageSize);
+        if (!page)
+        {
+            return NULL;
+        }
+
+        page->size = pool->pageSize;
+        page->pool = pool;
+
+        RK_BUFFER_SPIN_LOCK(&pool->lock);
+        pool->numPages++;
+        RK_BUFFER_SPIN_UNLOCK(&pool->lock);
+    }
+
+    page->refs = 1;
+    page->offset = 0;
+    page->next = NULL;
+
+    return page;
+}
+
+static void rkBufferRecyclePage(rkBufferPage *page)
+{
+    rkBufferPool *const pool = page->pool;
+    if (page->size != pool->pageSize)
+    {
+        free(page);
+        return;
+    }
+
+    RK_BUFFER_SPIN_LOCK(&pool->lock);
+    page->next = pool->freePages;
+    pool->freePages = page;
+    pool->numFree++;
+    RK_BUFFER_SPIN_UNLOCK(&pool->lock);
+}
+
+#endif /* RK_BUFFER_IMPLEMENTATION */
+#endif /* RK_BUFFER_H */
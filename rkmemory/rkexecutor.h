@@ -0,0 +1,773 @@
+#ifndef RK_EXECUTOR_H
+#define RK_EXECUTOR_H
+
+#include <stddef.h>
+
+#include "rkarena.h"
+
+// --- type definitions -------------------------------------------------------
+
+// Handle to the work-stealing executor
+typedef struct rkExecutor rkExecutor;
+
+// Handle to a task running on the executor
+typedef struct rkTask rkTask;
+
+/**
+ * The function a task runs
+ *
+ * @param[in] task
+ *      The running task, used to obtain its task-scoped arena
+ * @param[in] userData
+ *      The pointer passed when the task was submitted
+ */
+typedef void (*rkTaskFn)(rkTask *task, void *userData);
+
+// --- executor interface -----------------------------------------------------
+
+/**
+ * Creates a work-stealing executor. Every worker owns a Chase-Lev deque of
+ * tasks and a small local cache of arenas drawn from `pool`
+ *
+ * @param[in] numWorkers
+ *      The number of worker threads
+ * @param[in] pool
+ *      The pool task-scoped arenas are drawn from, or `NULL` to let the
+ *      executor create its own
+ *
+ * @return
+ *      A pointer to the newly created executor, or `NULL` upon failure
+ */
+rkExecutor *rkCreateExecutor(size_t numWorkers, rkArenaPool *pool);
+
+/**
+ * Waits for all tasks to complete, stops the workers and frees the executor
+ *
+ * @param[in] executor
+ *      A pointer to the executor to deallocate
+ */
+void rkFreeExecutor(rkExecutor *executor);
+
+/**
+ * Submits a task. From within a task the new task is pushed onto the
+ * calling worker's deque, otherwise it is injected into a shared queue
+ *
+ * @param[in] executor
+ *      A pointer to the executor
+ * @param[in] fn
+ *      The function the task runs
+ * @param[in] userData
+ *      The pointer passed to `fn`
+ *
+ * @return
+ *      `1` upon success, or `0` upon failure
+ */
+int rkExecutorSubmit(rkExecutor *executor, rkTaskFn fn, void *userData);
+
+/**
+ * Submits a task that owns `arena` from the start, e.g. because the
+ * submitter already filled it with the task's input. The arena travels with
+ * the task if it is stolen, and is released when the task completes
+ *
+ * @param[in] executor
+ *      A pointer to the executor
+ * @param[in] fn
+ *      The function the task runs
+ * @param[in] userData
+ *      The pointer passed to `fn`
+ * @param[in] arena
+ *      An arena obtained from `rkExecutorAcquireArena`
+ *
+ * @return
+ *      `1` upon success, or `0` upon failure
+ */
+int rkExecutorSubmitWithArena(rkExecutor *executor, rkTaskFn fn, void *userData, rkArena *arena);
+
+/**
+ * Takes an arena from the calling worker's local cache, or from the
+ * executor's pool if the cache is empty or the caller is not a worker
+ *
+ * @param[in] executor
+ *      A pointer to the executor
+ *
+ * @return
+ *      A pointer to the arena, or `NULL` upon failure
+ */
+rkArena *rkExecutorAcquireArena(rkExecutor *executor);
+
+/**
+ * Blocks until every submitted task, including the tasks they spawned, has
+ * completed
+ *
+ * @param[in] executor
+ *      A pointer to the executor
+ */
+void rkExecutorWait(rkExecutor *executor);
+
+/**
+ * Gets the task-scoped arena of `task`, acquiring one from the running
+ * worker's local cache on first use. The arena is reset and returned to the
+ * cache once the task completes
+ *
+ * @param[in] task
+ *      The running task
+ *
+ * @return
+ *      A pointer to the arena, or `NULL` upon failure
+ */
+rkArena *rkTaskArena(rkTask *task);
+
+/**
+ * Gets the number of tasks that were stolen from another worker's deque
+ *
+ * @param[in] executor
+ *      A pointer to the executor
+ *
+ * @return
+ *      The number of successful steals
+ */
+size_t rkExecutorSteals(const rkExecutor *executor);
+
+#if defined(RK_EXECUTOR_IMPLEMENTATION)
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- platform defines -------------------------------------------------------
+
+#if defined(_WIN32) || defined(_WIN64)
+#    error "Unimplemented: the executor needs POSIX threads"
+#endif /* platform detection */
+
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+// --- constants --------------------------------------------------------------
+
+#define RK_EXECUTOR_INITIAL_DEQUE 256
+#define RK_EXECUTOR_LOCAL_ARENAS 4
+#define RK_EXECUTOR_LOCAL_TASKS 1024
+#define RK_EXECUTOR_SPINS 64
+
+// --- macros -----------------------------------------------------------------
+
+#define RK_EXECUTOR_LOAD(ptr, order) __atomic_load_n((ptr), (order))
+#define RK_EXECUTOR_STORE(ptr, v, order) __atomic_store_n((ptr), (v), (order))
+#define RK_EXECUTOR_CAS(ptr, expected, desired) \
+    __atomic_compare_exchange_n((ptr), (expected), (desired), 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)
+#define RK_EXECUTOR_FENCE() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+// --- type definitions -------------------------------------------------------
+
+/**
+ * This struct defines a task
+ */
+typedef struct rkTask
+{
+    rkTaskFn           fn;       // The function to run
+    void              *userData; // The pointer passed to `fn`
+    rkArena           *arena;    // The task-scoped arena, or `NULL`
+    struct rkWorker   *worker;   // The worker running the task
+    struct rkTask     *next;     // The next task in a free list or queue
+} rkTask;
+
+/**
+ * This struct defines the circular buffer of a Chase-Lev deque
+ */
+typedef struct rkDequeBuffer
+{
+    int64_t               capacity; // The number of slots, a power of two
+    struct rkDequeBuffer *retired;  // The buffer this one replaced
+    rkTask               *slots[];  // The tasks
+} rkDequeBuffer;
+
+/**
+ * This struct defines a Chase-Lev work-stealing deque. The owner pushes and
+ * takes at the bottom while thieves steal from the top
+ */
+typedef struct rkDeque
+{
+    int64_t        top;    // The index thieves steal from
+    int64_t        bottom; // The index the owner pushes to
+    rkDequeBuffer *buffer; // The current circular buffer
+} rkDeque;
+
+/**
+ * This struct defines a worker thread
+ */
+typedef struct rkWorker
+{
+    rkDeque            deque;                            // The worker's tasks
+    struct rkExecutor *executor;                         // The owning executor
+    pthread_t          thread;                           // The worker thread
+    uint64_t           rng;                              // Picks steal victims
+    rkArena           *arenas[RK_EXECUTOR_LOCAL_ARENAS]; // The local arena cache
+    size_t             numArenas;                        // The number of cached arenas
+    rkTask            *freeTasks;                        // Recycled task structs
+    size_t             numFreeTasks;                     // The number of recycled tasks
+} rkWorker;
+
+/**
+ * This struct defines the executor
+ */
+typedef struct rkExecutor
+{
+    rkWorker       *workers;    // The workers
+    size_t          numWorkers; // The number of workers
+    size_t          numStarted; // The number of running worker threads
+    rkArenaPool    *pool;       // The pool arenas are drawn from
+    int             ownsPool;   // Whether `pool` was created by the executor
+    size_t          pending;    // Submitted tasks that have not completed
+    size_t          steals;     // The number of successful steals
+    int             stopping;   // Set when the workers should exit
+
+    pthread_mutex_t lock;       // Guards the injection queue and sleeping
+    pthread_cond_t  wake;       // Signalled when work is injected
+    pthread_cond_t  idle;       // Signalled when `pending` drops to zero
+    rkTask         *injectHead; // Tasks submitted from outside the workers
+    rkTask         *injectTail; // The tail of the injection queue
+    size_t          sleeping;   // The number of workers waiting on `wake`
+} rkExecutor;
+
+// --- global state -----------------------------------------------------------
+
+// The worker the calling thread runs, or `NULL` outside of the workers
+static __thread rkWorker *rkCurrentWorker = NULL;
+
+// --- function prototypes ----------------------------------------------------
+
+/**
+ * Pushes a task onto the bottom of the deque. Only the owner may push
+ *
+ * @return
+ *      `1` upon success, or `0` if the deque could not grow
+ */
+static int rkDequePush(rkDeque *deque, rkTask *task);
+
+/**
+ * Takes a task from the bottom of the deque. Only the owner may take
+ *
+ * @return
+ *      The task, or `NULL` if the deque is empty
+ */
+static rkTask *rkDequeTake(rkDeque *deque);
+
+/**
+ * Steals a task from the top of the deque
+ *
+ * @return
+ *      The task, or `NULL` if the deque is empty or the steal lost a race
+ */
+static rkTask *rkDequeSteal(rkDeque *deque);
+
+/**
+ * Allocates a deque buffer with `capacity` slots
+ */
+static rkDequeBuffer *rkNewDequeBuffer(int64_t capacity);
+
+/**
+ * Allocates a task struct, recycling one from the calling worker if possible
+ */
+static rkTask *rkNewTask(rkWorker *worker);
+
+/**
+ * Hands a task to the calling worker's deque, or the injection queue
+ */
+static int rkScheduleTask(rkExecutor *executor, rkTask *task);
+
+/**
+ * Runs a task and releases its arena and task struct
+ */
+static void rkRunTask(rkWorker *worker, rkTask *task);
+
+/**
+ * Finds the next task for `worker` from its deque, the injection queue or by
+ * stealing from the other workers
+ */
+static rkTask *rkFindTask(rkWorker *worker);
+
+/**
+ * Returns an arena to the worker's local cache, or to the pool if the cache
+ * is full
+ */
+static void rkReleaseArena(rkExecutor *executor, rkWorker *worker, rkArena *arena);
+
+/**
+ * The entry point of the worker threads
+ */
+static void *rkWorkerMain(void *arg);
+
+// --- executor interface -----------------------------------------------------
+
+rkExecutor *rkCreateExecutor(size_t numWorkers, rkArenaPool *pool)
+{
+    if (numWorkers == 0)
+    {
+        return NULL;
+    }
+
+    rkExecutor *const executor = (rkExecutor *)calloc(1, sizeof(rkExecutor));
+    if (!executor)
+    {
+        return NULL;
+    }
+
+    executor->workers = (rkWorker *)calloc(numWorkers, sizeof(rkWorker));
+    executor->pool = pool ? pool : rkCreateArenaPool(8 * 1024, RK_ARENA_FLAG_NONE, 0, 0);
+    executor->ownsPool = pool == NULL;
+    if (!executor->workers || !executor->pool)
+    {
+        if (executor->ownsPool && executor->pool)
+        {
+            rkFreeArenaPool(executor->pool);
+        }
+
+        free(executor->workers);
+        free(executor);
+        return NULL;
+    }
+
+    pthread_mutex_init(&executor->lock, NULL);
+    pthread_cond_init(&executor->wake, NULL);
+    pthread_cond_init(&executor->idle, NULL);
+
+    for (size_t i = 0; i < numWorkers; i++)
+    {
+        rkWorker *const worker = &executor->workers[i];
+        worker->executor = executor;
+        worker->rng = 0x9E3779B97F4A7C15ull * (i + 1);
+        worker->deque.buffer = rkNewDequeBuffer(RK_EXECUTOR_INITIAL_DEQUE);
+        executor->numWorkers++;
+        if (!worker->deque.buffer)
+        {
+            rkFreeExecutor(executor);
+            return NULL;
+        }
+    }
+
+    // Threads are only started once every deque exists, since they steal
+    // from each other right away
+    for (size_t i = 0; i < numWorkers; i++)
+    {
+        if (pthread_create(&executor->workers[i].thread, NULL, rkWorkerMain, &executor->workers[i]) != 0)
+        {
+            rkFreeExecutor(executor);
+            return NULL;
+        }
+
+        executor->numStarted++;
+    }
+
+    return executor;
+}
+
+void rkFreeExecutor(rkExecutor *executor)
+{
+    if (!executor)
+    {
+        return;
+    }
+
+    rkExecutorWait(executor);
+
+    pthread_mutex_lock(&executor->lock);
+    RK_EXECUTOR_STORE(&executor->stopping, 1, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&executor->wake);
+    pthread_mutex_unlock(&executor->lock);
+
+    for (size_t i = 0; i < executor->numWorkers; i++)
+    {
+        rkWorker *const worker = &executor->workers[i];
+        if (i < executor->numStarted)
+        {
+            pthread_join(worker->thread, NULL);
+        }
+
+        for (size_t j = 0; j < worker->numArenas; j++)
+        {
+            rkArenaPoolRelease(executor->pool, worker->arenas[j]);
+        }
+
+        while (worker->freeTasks)
+        {
+            rkTask *const task = worker->freeTasks;
+            worker->freeTasks = task->next;
+            free(task);
+        }
+
+        rkDequeBuffer *buffer = worker->deque.buffer;
+        while (buffer)
+        {
+            rkDequeBuffer *const retired = buffer->retired;
+            free(buffer);
+            buffer = retired;
+        }
+    }
+
+    if (executor->ownsPool)
+    {
+        rkFreeArenaPool(executor->pool);
+    }
+
+    pthread_cond_destroy(&executor->idle);
+    pthread_cond_destroy(&executor->wake);
+    pthread_mutex_destroy(&executor->lock);
+    free(executor->workers);
+    free(executor);
+}
+
+int rkExecutorSubmit(rkExecutor *executor, rkTaskFn fn, void *userData)
+{
+    return rkExecutorSubmitWithArena(executor, fn, userData, NULL);
+}
+
+int rkExecutorSubmitWithArena(rkExecutor *executor, rkTaskFn fn, void *userData, rkArena *arena)
+{
+    rkWorker *const worker = rkCurrentWorker && rkCurrentWorker->executor == executor ? rkCurrentWorker : NULL;
+    rkTask *const task = rkNewTask(worker);
+    if (!task)
+    {
+        return 0;
+    }
+
+    task->fn = fn;
+    task->userData = userData;
+    task->arena = arena;
+    task->worker = NULL;
+    task->next = NULL;
+
+    return rkScheduleTask(executor, task);
+}
+
+rkArena *rkExecutorAcquireArena(rkExecutor *executor)
+{
+    rkWorker *const worker = rkCurrentWorker;
+    if (worker && worker->executor == executor && worker->numArenas > 0)
+    {
+        return worker->arenas[--worker->numArenas];
+    }
+
+    return rkArenaPoolAcquire(executor->pool);
+}
+
+void rkExecutorWait(rkExecutor *executor)
+{
+    pthread_mutex_lock(&executor->lock);
+    while (RK_EXECUTOR_LOAD(&executor->pending, __ATOMIC_ACQUIRE) > 0)
+    {
+        pthread_cond_wait(&executor->idle, &executor->lock);
+    }
+    pthread_mutex_unlock(&executor->lock);
+}
+
+rkArena *rkTaskArena(rkTask *task)
+{
+    if (!task->arena)
+    {
+        task->arena = rkExecutorAcquireArena(task->worker->executor);
+    }
+
+    return task->arena;
+}
+
+size_t rkExecutorSteals(const rkExecutor *executor)
+{
+    return RK_EXECUTOR_LOAD(&executor->steals, __ATOMIC_RELAXED);
+}
+
+// --- utility functions ------------------------------------------------------
+
+static rkDequeBuffer *rkNewDequeBuffer(int64_t capacity)
+{
+    rkDequeBuffer *const buffer = (rkDequeBuffer *)malloc(sizeof(rkDequeBuffer) + (size_t)capacity * sizeof(rkTask *));
+    if (!buffer)
+    {
+        return NULL;
+    }
+
+    buffer->capacity = capacity;
+    buffer->retired = NULL;
+    return buffer;
+}
+
+static int rkDequePush(rkDeque *deque, rkTask *task)
+{
+    const int64_t b = RK_EXECUTOR_LOAD(&deque->bottom, __ATOMIC_RELAXED);
+    const int64_t t = RK_EXECUTOR_LOAD(&deque->top, __ATOMIC_ACQUIRE);
+    rkDequeBuffer *buffer = RK_EXECUTOR_LOAD(&deque->buffer, __ATOMIC_RELAXED);
+
+    if (b - t > buffer->capacity - 1)
+    {
+        // Thieves may still read the old buffer, so it is only freed along
+        // with the executor
+        rkDequeBuffer *const grown = rkNewDequeBuffer(buffer->capacity * 2);
+        if (!grown)
+        {
+            return 0;
+        }
+
+        for (int64_t i = t; i < b; i++)
+        {
+            grown->slots[i & (grown->capacity - 1)] = RK_EXECUTOR_LOAD(&buffer->slots[i & (buffer->capacity - 1)], __ATOMIC_RELAXED);
+        }
+
+        grown->retired = buffer;
+        RK_EXECUTOR_STORE(&deque->buffer, grown, __ATOMIC_RELEASE);
+        buffer = grown;
+    }
+
+    RK_EXECUTOR_STORE(&buffer->slots[b & (buffer->capacity - 1)], task, __ATOMIC_RELAXED);
+    RK_EXECUTOR_STORE(&deque->bottom, b + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+static rkTask *rkDequeTake(rkDeque *deque)
+{
+    const int64_t b = RK_EXECUTOR_LOAD(&deque->bottom, __ATOMIC_RELAXED) - 1;
+    rkDequeBuffer *const buffer = RK_EXECUTOR_LOAD(&deque->buffer, __ATOMIC_RELAXED);
+    RK_EXECUTOR_STORE(&deque->bottom, b, __ATOMIC_RELAXED);
+    RK_EXECUTOR_FENCE();
+
+    int64_t t = RK_EXECUTOR_LOAD(&deque->top, __ATOMIC_RELAXED);
+    if (t > b)
+    {
+        RK_EXECUTOR_STORE(&deque->bottom, b + 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    rkTask *task = RK_EXECUTOR_LOAD(&buffer->slots[b & (buffer->capacity - 1)], __ATOMIC_RELAXED);
+    if (t == b)
+    {
+        // The last task, race the thieves for it
+        if (!RK_EXECUTOR_CAS(&deque->top, &t, t + 1))
+        {
+            task = NULL;
+        }
+
+        RK_EXECUTOR_STORE(&deque->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+
+    return task;
+}
+
+static rkTask *rkDequeSteal(rkDeque *deque)
+{
+    int64_t t = RK_EXECUTOR_LOAD(&deque->top, __ATOMIC_ACQUIRE);
+    RK_EXECUTOR_FENCE();
+    const int64_t b = RK_EXECUTOR_LOAD(&deque->bottom, __ATOMIC_ACQUIRE);
+    if (t >= b)
+    {
+        return NULL;
+    }
+
+    rkDequeBuffer *const buffer = RK_EXECUTOR_LOAD(&deque->buffer, __ATOMIC_ACQUIRE);
+    rkTask *const task = RK_EXECUTOR_LOAD(&buffer->slots[t & (buffer->capacity - 1)], __ATOMIC_RELAXED);
+    if (!RK_EXECUTOR_CAS(&deque->top, &t, t + 1))
+    {
+        return NULL;
+    }
+
+    return task;
+}
+
+static rkTask *rkNewTask(rkWorker *worker)
+{
+    if (worker && worker->freeTasks)
+    {
+        rkTask *const task = worker->freeTasks;
+        worker->freeTasks = task->next;
+        worker->numFreeTasks--;
+        return task;
+    }
+
+    return (rkTask *)malloc(sizeof(rkTask));
+}
+
+static int rkScheduleTask(rkExecutor *executor, rkTask *task)
+{
+    __atomic_fetch_add(&executor->pending, 1, __ATOMIC_RELAXED);
+
+    rkWorker *const worker = rkCurrentWorker;
+    if (worker && worker->executor == executor && rkDequePush(&worker->deque, task))
+    {
+        if (RK_EXECUTOR_LOAD(&executor->sleeping, __ATOMIC_RELAXED) > 0)
+        {
+            pthread_mutex_lock(&executor->lock);
+            pthread_cond_signal(&executor->wake);
+            pthread_mutex_unlock(&executor->lock);
+        }
+
+        return 1;
+    }
+
+    pthread_mutex_lock(&executor->lock);
+    if (executor->injectTail)
+    {
+        executor->injectTail->next = task;
+    }
+    else
+    {
+        RK_EXECUTOR_STORE(&executor->injectHead, task, __ATOMIC_RELAXED);
+    }
+    executor->injectTail = task;
+    pthread_cond_signal(&executor->wake);
+    pthread_mutex_unlock(&executor->lock);
+
+    return 1;
+}
+
+static void rkRunTask(rkWorker *worker, rkTask *task)
+{
+    task->worker = worker;
+    task->fn(task, task->userData);
+
+    rkExecutor *const executor = worker->executor;
+    if (task->arena)
+    {
+        rkReleaseArena(executor, worker, task->arena);
+    }
+
+    if (worker->numFreeTasks < RK_EXECUTOR_LOCAL_TASKS)
+    {
+        task->next = worker->freeTasks;
+        worker->freeTasks = task;
+        worker->numFreeTasks++;
+    }
+    else
+    {
+        free(task);
+    }
+
+    if (__atomic_sub_fetch(&executor->pending, 1, __ATOMIC_ACQ_REL) == 0)
+    {
+        pthread_mutex_lock(&executor->lock);
+        pthread_cond_broadcast(&executor->idle);
+        pthread_mutex_unlock(&executor->lock);
+    }
+}
+
+static rkTask *rkFindTask(rkWorker *worker)
+{
+    rkTask *task = rkDequeTake(&worker->deque);
+    if (task)
+    {
+        return task;
+    }
+
+    rkExecutor *const executor = worker->executor;
+    if (RK_EXECUTOR_LOAD(&executor->injectHead, __ATOMIC_RELAXED))
+    {
+        pthread_mutex_lock(&executor->lock);
+        task = executor->injectHead;
+        if (task)
+        {
+            RK_EXECUTOR_STORE(&executor->injectHead, task->next, __ATOMIC_RELAXED);
+            if (!executor->injectHead)
+            {
+                executor->injectTail = NULL;
+            }
+        }
+        pthread_mutex_unlock(&executor->lock);
+
+        if (task)
+        {
+            return task;
+        }
+    }
+
+    const size_t n = executor->numWorkers;
+    if (n < 2)
+    {
+        return NULL;
+    }
+
+    worker->rng ^= worker->rng << 13;
+    worker->rng ^= worker->rng >> 7;
+    worker->rng ^= worker->rng << 17;
+
+    const size_t start = (size_t)(worker->rng % n);
+    for (size_t i = 0; i < n; i++)
+    {
+        rkWorker *const victim = &executor->workers[(start + i) % n];
+        if (victim == worker)
+        {
+            continue;
+        }
+
+        task = rkDequeSteal(&victim->deque);
+        if (task)
+        {
+            __atomic_fetch_add(&executor->steals, 1, __ATOMIC_RELAXED);
+            return task;
+        }
+    }
+
+    return NULL;
+}
+
+static void rkReleaseArena(rkExecutor *executor, rkWorker *worker, rkArena *arena)
+{
+    if (worker->numArenas < RK_EXECUTOR_LOCAL_ARENAS)
+    {
+        rkResetArena(arena);
+        worker->arenas[worker->numArenas++] = arena;
+        return;
+    }
+
+    rkArenaPoolRelease(executor->pool, arena);
+}
+
+static void *rkWorkerMain(void *arg)
+{
+    rkWorker *const worker = (rkWorker *)arg;
+    rkExecutor *const executor = worker->executor;
+    rkCurrentWorker = worker;
+
+    size_t spins = 0;
+    while (!RK_EXECUTOR_LOAD(&executor->stopping, __ATOMIC_ACQUIRE))
+    {
+        rkTask *const task = rkFindTask(worker);
+        if (task)
+        {
+            rkRunTask(worker, task);
+            spins = 0;
+            continue;
+        }
+
+        if (++spins < RK_EXECUTOR_SPINS)
+        {
+            sched_yield();
+            continue;
+        }
+
+        // Tasks pushed onto other deques only signal sleepers, so the timed
+        // wait bounds how long a missed wakeup can delay a steal
+        pthread_mutex_lock(&executor->lock);
+        if (!executor->injectHead && !RK_EXECUTOR_LOAD(&executor->stopping, __ATOMIC_ACQUIRE))
+        {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += 1000000;
+            if (deadline.tv_nsec >= 1000000000)
+            {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
+            }
+
+            executor->sleeping++;
+            pthread_cond_timedwait(&executor->wake, &executor->lock, &deadline);
+            executor->sleeping--;
+        }
+        pthread_mutex_unlock(&executor->lock);
+        spins = 0;
+    }
+
+    rkCurrentWorker = NULL;
+    return NULL;
+}
+
+#endif /* RK_EXECUTOR_IMPLEMENTATION */
+
+#endif /* RK_EXECUTOR_H */
@@ -0,0 +1,410 @@
+#ifndef RK_POOL_H
+#define RK_POOL_H
+
+#include <stddef.h>
+
+// --- type definitions -------------------------------------------------------
+
+// Handle to a pool of fixed-size objects
+typedef struct rkPool rkPool;
+
+/**
+ * A snapshot of the state of an object pool
+ */
+typedef struct rkPoolStats
+{
+    size_t heapCount;        // The number of per-thread heaps, live or orphaned
+    size_t carvedObjects;    // The number of objects carved out of slabs
+    size_t remoteFrees;      // The number of objects freed by a thread other than their owner
+    size_t remoteReclaimed;  // The number of remotely freed objects taken back by their owner
+} rkPoolStats;
+
+// --- pool interface ---------------------------------------------------------
+
+/**
+ * Creates a pool of fixed-size objects. Every thread allocates from its own
+ * heap, with a magazine of free objects in front of it. Objects may be freed
+ * from any thread: objects freed by a thread other than their owner are
+ * pushed onto the owner's lock-free remote list and reclaimed in batches by
+ * the owner. The heap of an exited thread is adopted by the next new thread
+ *
+ * @param[in] objectSize
+ *      The size of the objects in bytes
+ * @param[in] objectsPerSlab
+ *      The number of objects a heap carves out of its arena at a time
+ *
+ * @return
+ *      A pointer to the newly created pool, or `NULL` upon failure
+ */
+rkPool *rkCreatePool(size_t objectSize, size_t objectsPerSlab);
+
+/**
+ * Frees the pool and every object allocated from it. No thread may use the
+ * pool or its objects anymore
+ *
+ * @param[in] pool
+ *      A pointer to the pool to deallocate
+ */
+void rkFreePool(rkPool *pool);
+
+/**
+ * Allocates an object from the calling thread's heap. The contents of the
+ * object are undefined. This function is thread-safe
+ *
+ * @param[in] pool
+ *      A pointer to the pool to allocate from
+ *
+ * @return
+ *      A pointer to the object, aligned to 16 bytes, or `NULL` upon failure
+ */
+void *rkPoolAlloc(rkPool *pool);
+
+/**
+ * Returns an object to the pool. Objects of the calling thread's own heap go
+ * into its magazine, while all others are pushed onto their owner's remote
+ * list. This function is thread-safe
+ *
+ * @param[in] pool
+ *      A pointer to the pool the object was allocated from
+ * @param[in] ptr
+ *      A pointer to the object, may be `NULL`
+ */
+void rkPoolFree(rkPool *pool, void *ptr);
+
+/**
+ * Collects the state of the pool
+ *
+ * @param[in] pool
+ *      A pointer to the pool
+ * @param[out] stats
+ *      The stats to populate
+ */
+void rkPoolGetStats(const rkPool *pool, rkPoolStats *stats);
+
+#if defined(RK_POOL_IMPLEMENTATION)
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rkarena.h"
+
+// --- platform defines -------------------------------------------------------
+
+#if defined(_WIN32) || defined(_WIN64)
+#    error "Unimplemented: the object pool needs POSIX threads"
+#endif /* platform detection */
+
+#include <pthread.h>
+
+// --- constants --------------------------------------------------------------
+
+// Objects start 16 bytes past their header and are 16 byte aligned
+#define RK_POOL_ALIGNMENT 16
+
+// A full magazine spills half of its objects into the heap's free list, and
+// an empty one is refilled with up to a full magazine
+#define RK_POOL_MAGAZINE 64
+
+// --- macros -----------------------------------------------------------------
+
+#define RK_POOL_LOAD(ptr, order) __atomic_load_n((ptr), (order))
+#define RK_POOL_STORE(ptr, v, order) __atomic_store_n((ptr), (v), (order))
+#define RK_POOL_EXCHANGE(ptr, v, order) __atomic_exchange_n((ptr), (v), (order))
+#define RK_POOL_CAS(ptr, expected, desired) \
+    __atomic_compare_exchange_n((ptr), (expected), (desired), 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED)
+#define RK_POOL_ADD(ptr, v) __atomic_fetch_add((ptr), (v), __ATOMIC_RELAXED)
+
+// --- type definitions -------------------------------------------------------
+
+/**
+ * This struct defines the header in front of every object
+ */
+typedef struct rkPoolObject
+{
+    struct rkPoolHeap   *owner; // The heap the object was carved by
+    struct rkPoolObject *next;  // The next free object in a free or remote list
+} rkPoolObject;
+
+/**
+ * This struct defines the heap of one thread
+ */
+typedef struct rkPoolHeap
+{
+    struct rkPool     *pool;                        // The owning pool
+    rkPoolObject      *magazine[RK_POOL_MAGAZINE];  // The most recently freed objects
+    size_t             numMagazine;                 // The number of objects in the magazine
+    rkPoolObject      *freeList;                    // Objects spilled from the magazine
+    uint8_t           *cursor;                      // The next object in the current slab
+    uint8_t           *end;                         // The end of the current slab
+    rkArena           *arena;                       // The arena slabs are carved from
+    int                orphaned;                    // Set once the owning thread has exited
+    struct rkPoolHeap *next;                        // The next heap of the pool
+
+    // Written by other threads, so kept away from the owner's fields
+    uint8_t            pad[64];
+    rkPoolObject      *remote;                      // Objects freed by other threads
+} rkPoolHeap;
+
+/**
+ * This struct defines the object pool
+ */
+typedef struct rkPool
+{
+    size_t          stride;          // The size of an object and its header
+    size_t          slabBytes;       // The size of a slab in bytes
+    pthread_key_t   key;             // Maps threads to their heaps
+    rkPoolHeap     *heaps;           // Every heap ever created
+    size_t          carved;          // The number of objects carved out of slabs
+    size_t          remoteFrees;     // The number of remote frees
+    size_t          remoteReclaimed; // The number of reclaimed remote frees
+} rkPool;
+
+// --- function prototypes ----------------------------------------------------
+
+/**
+ * Gets the heap of the calling thread, adopting an orphaned heap or creating
+ * a new one on first use
+ */
+static rkPoolHeap *rkPoolHeapOf(rkPool *pool);
+
+/**
+ * Refills the empty magazine of `heap` from its free list, its remote list
+ * or a slab, in that order
+ *
+ * @return
+ *      `1` upon success, or `0` if a new slab could not be allocated
+ */
+static int rkPoolRefill(rkPoolHeap *heap);
+
+/**
+ * Orphans the heap of an exiting thread, so that another thread can adopt it
+ */
+static void rkPoolOrphanHeap(void *arg);
+
+// --- pool interface ---------------------------------------------------------
+
+rkPool *rkCreatePool(size_t objectSize, size_t objectsPerSlab)
+{
+    if (objectSize == 0 || objectsPerSlab == 0)
+    {
+        return NULL;
+    }
+
+    rkPool *const pool = (rkPool *)calloc(1, sizeof(rkPool));
+    if (!pool)
+    {
+        return NULL;
+    }
+
+    pool->stride = (sizeof(rkPoolObject) + objectSize + RK_POOL_ALIGNMENT - 1) & ~(size_t)(RK_POOL_ALIGNMENT - 1);
+    pool->slabBytes = pool->stride * objectsPerSlab;
+    if (pthread_key_create(&pool->key, rkPoolOrphanHeap) != 0)
+    {
+        free(pool);
+        return NULL;
+    }
+
+    return pool;
+}
+
+void rkFreePool(rkPool *pool)
+{
+    if (!pool)
+    {
+        return;
+    }
+
+    pthread_key_delete(pool->key);
+
+    rkPoolHeap *heap = pool->heaps;
+    while (heap)
+    {
+        rkPoolHeap *const next = heap->next;
+        rkFreeArena(heap->arena);
+        free(heap);
+        heap = next;
+    }
+
+    free(pool);
+}
+
+void *rkPoolAlloc(rkPool *pool)
+{
+    rkPoolHeap *const heap = rkPoolHeapOf(pool);
+    if (!heap)
+    {
+        return NULL;
+    }
+
+    if (heap->numMagazine == 0 && !rkPoolRefill(heap))
+    {
+        return NULL;
+    }
+
+    rkPoolObject *const object = heap->magazine[--heap->numMagazine];
+    return (void *)(object + 1);
+}
+
+void rkPoolFree(rkPool *pool, void *ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    rkPoolObject *const object = (rkPoolObject *)ptr - 1;
+    rkPoolHeap *const owner = object->owner;
+    if (owner != (rkPoolHeap *)pthread_getspecific(pool->key))
+    {
+        // The owner takes the whole list at once, so the push cannot suffer
+        // from ABA
+        object->next = RK_POOL_LOAD(&owner->remote, __ATOMIC_RELAXED);
+        while (!RK_POOL_CAS(&owner->remote, &object->next, object))
+        {
+        }
+
+        RK_POOL_ADD(&pool->remoteFrees, 1);
+        return;
+    }
+
+    if (owner->numMagazine == RK_POOL_MAGAZINE)
+    {
+        for (size_t i = RK_POOL_MAGAZINE / 2; i < RK_POOL_MAGAZINE; i++)
+        {
+            owner->magazine[i]->next = owner->freeList;
+            owner->freeList = owner->magazine[i];
+        }
+
+        owner->numMagazine = RK_POOL_MAGAZINE / 2;
+    }
+
+    owner->magazine[owner->numMagazine++] = object;
+}
+
+void rkPoolGetStats(const rkPool *pool, rkPoolStats *stats)
+{
+    memset(stats, 0, sizeof(rkPoolStats));
+    for (const rkPoolHeap *heap = RK_POOL_LOAD(&pool->heaps, __ATOMIC_ACQUIRE); heap; heap = heap->next)
+    {
+        stats->heapCount++;
+    }
+
+    stats->carvedObjects = RK_POOL_LOAD(&pool->carved, __ATOMIC_RELAXED);
+    stats->remoteFrees = RK_POOL_LOAD(&pool->remoteFrees, __ATOMIC_RELAXED);
+    stats->remoteReclaimed = RK_POOL_LOAD(&pool->remoteReclaimed, __ATOMIC_RELAXED);
+}
+
+// --- utility functions ------------------------------------------------------
+
+static rkPoolHeap *rkPoolHeapOf(rkPool *pool)
+{
+    rkPoolHeap *heap = (rkPoolHeap *)pthread_getspecific(pool->key);
+    if (heap)
+    {
+        return heap;
+    }
+
+    for (heap = RK_POOL_LOAD(&pool->heaps, __ATOMIC_ACQUIRE); heap; heap = heap->next)
+    {
+        int orphaned = 1;
+        if (RK_POOL_LOAD(&heap->orphaned, __ATOMIC_RELAXED) &&
+            __atomic_compare_exchange_n(&heap->orphaned, &orphaned, 0, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            pthread_setspecific(pool->key, heap);
+            return heap;
+        }
+    }
+
+    heap = (rkPoolHeap *)calloc(1, sizeof(rkPoolHeap));
+    if (!heap)
+    {
+        return NULL;
+    }
+
+    heap->pool = pool;
+    heap->arena = rkCreateArenaWithPageSize(pool->slabBytes);
+    if (!heap->arena || pthread_setspecific(pool->key, heap) != 0)
+    {
+        if (heap->arena)
+        {
+            rkFreeArena(heap->arena);
+        }
+
+        free(heap);
+        return NULL;
+    }
+
+    heap->next = RK_POOL_LOAD(&pool->heaps, __ATOMIC_RELAXED);
+    while (!RK_POOL_CAS(&pool->heaps, &heap->next, heap))
+    {
+    }
+
+    return heap;
+}
+
+static int rkPoolRefill(rkPoolHeap *heap)
+{
+    if (!heap->freeList)
+    {
+        heap->freeList = RK_POOL_EXCHANGE(&heap->remote, NULL, __ATOMIC_ACQUIRE);
+
+        size_t reclaimed = 0;
+        for (const rkPoolObject *o = heap->freeList; o; o = o->next)
+        {
+            reclaimed++;
+        }
+        RK_POOL_ADD(&heap->pool->remoteReclaimed, reclaimed);
+    }
+
+    while (heap->freeList && heap->numMagazine < RK_POOL_MAGAZINE)
+    {
+        heap->magazine[heap->numMagazine++] = heap->freeList;
+        heap->freeList = heap->freeList->next;
+    }
+
+    if (heap->numMagazine > 0)
+    {
+        return 1;
+    }
+
+    rkPool *const pool = heap->pool;
+    if (heap->cursor == heap->end)
+    {
+        heap->cursor = (uint8_t *)rkArenaAlloc(heap->arena, pool->slabBytes);
+        if (!heap->cursor)
+        {
+            heap->end = NULL;
+            return 0;
+        }
+
+        heap->end = heap->cursor + pool->slabBytes;
+    }
+
+    while (heap->cursor < heap->end && heap->numMagazine < RK_POOL_MAGAZINE)
+    {
+        rkPoolObject *const object = (rkPoolObject *)heap->cursor;
+        object->owner = heap;
+        heap->magazine[heap->numMagazine++] = object;
+        heap->cursor += pool->stride;
+    }
+
+    RK_POOL_ADD(&pool->carved, heap->numMagazine);
+    return 1;
+}
+
+static void rkPoolOrphanHeap(void *arg)
+{
+    rkPoolHeap *const heap = (rkPoolHeap *)arg;
+    while (heap->numMagazine > 0)
+    {
+        rkPoolObject *const object = heap->magazine[--heap->numMagazine];
+        object->next = heap->freeList;
+        heap->freeList = object;
+    }
+
+    RK_POOL_STORE(&heap->orphaned, 1, __ATOMIC_RELEASE);
+}
+
+#endif /* RK_POOL_IMPLEMENTATION */
+#endif /* RK_POOL_H */
@@ -0,0 +1,572 @@
+#ifndef RK_PRESSURE_H
+#define RK_PRESSURE_H
+
+#include <stddef.h>
+
+#include "rkarena.h"
+
+// --- type definitions -------------------------------------------------------
+
+// Handle to the memory pressure monitor
+typedef struct rkPressureMonitor rkPressureMonitor;
+
+/**
+ * The memory pressure levels reported by the monitor
+ */
+typedef enum rkPressureLevel
+{
+    RK_PRESSURE_NONE, // Neither threshold has been crossed
+    RK_PRESSURE_SOME, // Some tasks are stalled on memory beyond the threshold
+    RK_PRESSURE_FULL  // All tasks are stalled on memory beyond the threshold
+} rkPressureLevel;
+
+/**
+ * Invoked when the pressure crosses a threshold. The callback should release
+ * whatever retained memory it can
+ *
+ * @param[in] userData
+ *      The pointer passed when the callback was registered
+ * @param[in] level
+ *      The pressure level that was detected
+ *
+ * @return
+ *      The number of bytes released back to the OS
+ */
+typedef size_t (*rkPressureCallback)(void *userData, rkPressureLevel level);
+
+// --- pressure monitor interface ---------------------------------------------
+
+/**
+ * Creates a monitor that reads Linux PSI data from `path`. The file has to
+ * be in the PSI format, i.e. `some avg10=...` and `full avg10=...` lines, so
+ * any regular file may be used to fake the pressure
+ *
+ * @param[in] path
+ *      The path to the pressure file, or `NULL` for `/proc/pressure/memory`.
+ *      A cgroup's `memory.pressure` file may be used as well
+ * @param[in] someThreshold
+ *      The `some avg10` percentage at which `RK_PRESSURE_SOME` is reported
+ * @param[in] fullThreshold
+ *      The `full avg10` percentage at which `RK_PRESSURE_FULL` is reported
+ *
+ * @return
+ *      A pointer to the newly created monitor, or `NULL` upon failure
+ */
+rkPressureMonitor *rkCreatePressureMonitor(const char *path, float someThreshold, float fullThreshold);
+
+/**
+ * Frees the monitor. Registered arenas and callbacks are left untouched
+ *
+ * @param[in] monitor
+ *      A pointer to the monitor to deallocate
+ */
+void rkFreePressureMonitor(rkPressureMonitor *monitor);
+
+/**
+ * Arms a kernel PSI trigger on the pressure file so that
+ * `rkPressureMonitorWait` sleeps in `poll` until the kernel reports a stall
+ * of `stallUs` microseconds within a `windowUs` microsecond window
+ *
+ * @param[in] monitor
+ *      A pointer to the monitor
+ * @param[in] stallUs
+ *      The stall time in microseconds that fires the trigger
+ * @param[in] windowUs
+ *      The tracking window in microseconds
+ *
+ * @return
+ *      `1` if the trigger was armed, or `0` if the file does not support
+ *      triggers (e.g. a fake pressure file or an older kernel)
+ */
+int rkPressureMonitorArmTrigger(rkPressureMonitor *monitor, unsigned stallUs, unsigned windowUs);
+
+/**
+ * Registers a callback that is invoked whenever a threshold is crossed
+ *
+ * @param[in] monitor
+ *      A pointer to the monitor
+ * @param[in] callback
+ *      The callback to invoke
+ * @param[in] userData
+ *      The pointer to pass to the callback
+ *
+ * @return
+ *      `1` upon success, or `0` upon failure
+ */
+int rkPressureRegister(rkPressureMonitor *monitor, rkPressureCallback callback, void *userData);
+
+/**
+ * Removes a callback previously registered with `rkPressureRegister`
+ *
+ * @param[in] monitor
+ *      A pointer to the monitor
+ * @param[in] callback
+ *      The registered callback
+ * @param[in] userData
+ *      The registered user data
+ */
+void rkPressureUnregister(rkPressureMonitor *monitor, rkPressureCallback callback, void *userData);
+
+/**
+ * Registers an arena whose page cache is released under pressure. The
+ * monitor only requests the trim with `rkArenaRequestTrim`, and the thread
+ * owning the arena releases the cache on its next reset or new page, so the
+ * released bytes are reported by the check after that
+ *
+ * @param[in] monitor
+ *      A pointer to the monitor
+ * @param[in] arena
+ *      A pointer to the arena to trim under pressure
+ *
+ * @return
+ *      `1` upon success, or `0` upon failure
+ */
+int rkPressureWatchArena(rkPressureMonitor *monitor, rkArena *arena);
+
+/**
+ * Removes an arena previously registered with `rkPressureWatchArena`
+ *
+ * @param[in] monitor
+ *      A pointer to the monitor
+ * @param[in] arena
+ *      A pointer to the arena
+ */
+void rkPressureUnwatchArena(rkPressureMonitor *monitor, rkArena *arena);
+
+/**
+ * Registers an arena pool whose idle arenas are freed under pressure
+ *
+ * @param[in] monitor
+ *      A pointer to the monitor
+ * @param[in] pool
+ *      A pointer to the arena pool to trim under pressure
+ *
+ * @return
+ *      `1` upon success, or `0` upon failure
+ */
+int rkPressureWatchArenaPool(rkPressureMonitor *monitor, rkArenaPool *pool);
+
+/**
+ * Removes an arena pool previously registered with
+ * `rkPressureWatchArenaPool`
+ *
+ * @param[in] monitor
+ *      A pointer to the monitor
+ * @param[in] pool
+ *      A pointer to the arena pool
+ */
+void rkPressureUnwatchArenaPool(rkPressureMonitor *monitor, rkArenaPool *pool);
+
+/**
+ * Reads the pressure file once and invokes the registered callbacks if a
+ * threshold has been crossed
+ *
+ * @param[in] monitor
+ *      A pointer to the monitor
+ *
+ * @return
+ *      The detected pressure level
+ */
+rkPressureLevel rkPressureMonitorCheck(rkPressureMonitor *monitor);
+
+/**
+ * Waits up to `timeoutMs` milliseconds for the armed trigger to fire, then
+ * performs `rkPressureMonitorCheck`. Without an armed trigger this sleeps for
+ * the full timeout before checking. A trigger that reports an error is
+ * disarmed, after which the monitor sleeps as if it had never been armed
+ *
+ * @param[in] monitor
+ *      A pointer to the monitor
+ * @param[in] timeoutMs
+ *      The maximum time to wait in milliseconds
+ *
+ * @return
+ *      The detected pressure level
+ */
+rkPressureLevel rkPressureMonitorWait(rkPressureMonitor *monitor, int timeoutMs);
+
+/**
+ * Gets the total number of bytes released by callbacks since the monitor was
+ * created
+ *
+ * @param[in] monitor
+ *      A pointer to the monitor
+ *
+ * @return
+ *      The number of bytes released
+ */
+size_t rkPressureReleasedBytes(const rkPressureMonitor *monitor);
+
+#if defined(RK_PRESSURE_IMPLEMENTATION)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- platform defines -------------------------------------------------------
+
+#if defined(_WIN32) || defined(_WIN64)
+#    define RK_PRESSURE_PLATFORM_WINDOWS
+#elif defined(__linux__)
+#    define RK_PRESSURE_PLATFORM_LINUX
+#endif /* platform detection */
+
+// --- platform dependent includes --------------------------------------------
+
+#if defined(RK_PRESSURE_PLATFORM_LINUX)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+#elif defined(RK_PRESSURE_PLATFORM_WINDOWS)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+// --- constants --------------------------------------------------------------
+
+#define RK_PRESSURE_DEFAULT_PATH "/proc/pressure/memory"
+#define RK_PRESSURE_MAX_PATH 4096
+
+#define RK_PRESSURE_PROC_MAGIC    0x9fa0
+#define RK_PRESSURE_CGROUP2_MAGIC 0x63677270
+
+// --- type definitions -------------------------------------------------------
+
+/**
+ * This struct defines a registered pressure callback
+ */
+typedef struct rkPressureWatcher
+{
+    rkPressureCallback callback; // The function to invoke under pressure
+    void              *userData; // The pointer passed to the callback
+} rkPressureWatcher;
+
+/**
+ * This struct defines the pressure monitor
+ */
+typedef struct rkPressureMonitor
+{
+    char               path[RK_PRESSURE_MAX_PATH]; // The pressure file path
+    float              someThreshold;              // Threshold for `some avg10`
+    float              fullThreshold;              // Threshold for `full avg10`
+    int                triggerFd;                  // The armed PSI trigger, or -1
+    rkPressureWatcher *watchers;                   // The registered callbacks
+    size_t             numWatchers;                // The number of callbacks
+    size_t             capWatchers;                // The capacity of `watchers`
+    size_t             released;                   // Total bytes released
+} rkPressureMonitor;
+
+// --- function prototypes ----------------------------------------------------
+
+/**
+ * Reads the `avg10` values of the `some` and `full` lines in the pressure file
+ *
+ * @param[in] path
+ *      The path to the pressure file
+ * @param[out] some
+ *      The `some avg10` percentage
+ * @param[out] full
+ *      The `full avg10` percentage
+ *
+ * @return
+ *      `1` upon success, or `0` if the file could not be read
+ */
+static int rkReadPressure(const char *path, float *some, float *full);
+
+/**
+ * Invokes all the registered callbacks with `level`
+ *
+ * @param[in] monitor
+ *      A pointer to the monitor
+ * @param[in] level
+ *      The detected pressure level
+ */
+static void rkDispatchPressure(rkPressureMonitor *monitor, rkPressureLevel level);
+
+/**
+ * The callback registered by `rkPressureWatchArena`
+ */
+static size_t rkTrimArenaUnderPressure(void *userData, rkPressureLevel level);
+
+/**
+ * The callback registered by `rkPressureWatchArenaPool`
+ */
+static size_t rkTrimArenaPoolUnderPressure(void *userData, rkPressureLevel level);
+
+// --- pressure monitor interface ---------------------------------------------
+
+rkPressureMonitor *rkCreatePressureMonitor(const char *path, float someThreshold, float fullThreshold)
+{
+    if (!path)
+    {
+        path = RK_PRESSURE_DEFAULT_PATH;
+    }
+
+    if (strlen(path) >= RK_PRESSURE_MAX_PATH)
+    {
+        return NULL;
+    }
+
+    rkPressureMonitor *const monitor = (rkPressureMonitor *)malloc(sizeof(rkPressureMonitor));
+    if (!monitor)
+    {
+        return NULL;
+    }
+
+    strcpy(monitor->path, path);
+    monitor->someThreshold = someThreshold;
+    monitor->fullThreshold = fullThreshold;
+    monitor->triggerFd = -1;
+    monitor->watchers = NULL;
+    monitor->numWatchers = 0;
+    monitor->capWatchers = 0;
+    monitor->released = 0;
+
+    return monitor;
+}
+
+void rkFreePressureMonitor(rkPressureMonitor *monitor)
+{
+    if (!monitor)
+    {
+        return;
+    }
+
+#if defined(RK_PRESSURE_PLATFORM_LINUX)
+    if (monitor->triggerFd >= 0)
+    {
+        close(monitor->triggerFd);
+    }
+#endif
+
+    free(monitor->watchers);
+    free(monitor);
+}
+
+int rkPressureMonitorArmTrigger(rkPressureMonitor *monitor, unsigned stallUs, unsigned windowUs)
+{
+#if defined(RK_PRESSURE_PLATFORM_LINUX)
+    if (monitor->triggerFd >= 0)
+    {
+        close(monitor->triggerFd);
+        monitor->triggerFd = -1;
+    }
+
+    const int fd = open(monitor->path, O_RDWR | O_NONBLOCK);
+    if (fd < 0)
+    {
+        return 0;
+    }
+
+    // Triggers only exist on procfs and cgroupfs, writing to anything else
+    // (like a fake pressure file) would clobber it
+    struct statfs fs;
+    if (fstatfs(fd, &fs) != 0 || (fs.f_type != RK_PRESSURE_PROC_MAGIC && fs.f_type != RK_PRESSURE_CGROUP2_MAGIC))
+    {
+        close(fd);
+        return 0;
+    }
+
+    char trigger[64];
+    const int len = snprintf(trigger, sizeof(trigger), "some %u %u", stallUs, windowUs);
+    if (write(fd, trigger, (size_t)len + 1) < 0)
+    {
+        close(fd);
+        return 0;
+    }
+
+    monitor->triggerFd = fd;
+    return 1;
+#else
+    (void)monitor;
+    (void)stallUs;
+    (void)windowUs;
+    return 0;
+#endif /* RK_PRESSURE_PLATFORM_LINUX */
+}
+
+int rkPressureRegister(rkPressureMonitor *monitor, rkPressureCallback callback, void *userData)
+{
+    if (monitor->numWatchers == monitor->capWatchers)
+    {
+        const size_t cap = monitor->capWatchers ? monitor->capWatchers * 2 : 8;
+        rkPressureWatcher *const watchers = (rkPressureWatcher *)realloc(monitor->watchers, cap * sizeof(rkPressureWatcher));
+        if (!watchers)
+        {
+            return 0;
+        }
+
+        monitor->watchers = watchers;
+        monitor->capWatchers = cap;
+    }
+
+    monitor->watchers[monitor->numWatchers].callback = callback;
+    monitor->watchers[monitor->numWatchers].userData = userData;
+    monitor->numWatchers++;
+
+    return 1;
+}
+
+void rkPressureUnregister(rkPressureMonitor *monitor, rkPressureCallback callback, void *userData)
+{
+    for (size_t i = 0; i < monitor->numWatchers; i++)
+    {
+        if (monitor->watchers[i].callback == callback && monitor->watchers[i].userData == userData)
+        {
+            monitor->watchers[i] = monitor->watchers[--monitor->numWatchers];
+            return;
+        }
+    }
+}
+
+int rkPressureWatchArena(rkPressureMonitor *monitor, rkArena *arena)
+{
+    return rkPressureRegister(monitor, rkTrimArenaUnderPressure, (void *)arena);
+}
+
+void rkPressureUnwatchArena(rkPressureMonitor *monitor, rkArena *arena)
+{
+    rkPressureUnregister(monitor, rkTrimArenaUnderPressure, (void *)arena);
+}
+
+int rkPressureWatchArenaPool(rkPressureMonitor *monitor, rkArenaPool *pool)
+{
+    return rkPressureRegister(monitor, rkTrimArenaPoolUnderPressure, (void *)pool);
+}
+
+void rkPressureUnwatchArenaPool(rkPressureMonitor *monitor, rkArenaPool *pool)
+{
+    rkPressureUnregister(monitor, rkTrimArenaPoolUnderPressure, (void *)pool);
+}
+
+rkPressureLevel rkPressureMonitorCheck(rkPressureMonitor *monitor)
+{
+    float some = 0.0f;
+    float full = 0.0f;
+    if (!rkReadPressure(monitor->path, &some, &full))
+    {
+        return RK_PRESSURE_NONE;
+    }
+
+    rkPressureLevel level = RK_PRESSURE_NONE;
+    if (full >= monitor->fullThreshold)
+    {
+        level = RK_PRESSURE_FULL;
+    }
+    else if (some >= monitor->someThreshold)
+    {
+        level = RK_PRESSURE_SOME;
+    }
+
+    rkDispatchPressure(monitor, level);
+    return level;
+}
+
+rkPressureLevel rkPressureMonitorWait(rkPressureMonitor *monitor, int timeoutMs)
+{
+#if defined(RK_PRESSURE_PLATFORM_LINUX)
+    if (monitor->triggerFd >= 0)
+    {
+        struct pollfd pfd = { .fd = monitor->triggerFd, .events = POLLPRI, .revents = 0 };
+        const int n = poll(&pfd, 1, timeoutMs);
+        if (n > 0 && (pfd.revents & POLLPRI))
+        {
+            // The kernel has already decided that the stall budget has been
+            // exceeded, even if `avg10` lags behind the threshold
+            const rkPressureLevel level = rkPressureMonitorCheck(monitor);
+            if (level == RK_PRESSURE_NONE)
+            {
+                rkDispatchPressure(monitor, RK_PRESSURE_SOME);
+                return RK_PRESSURE_SOME;
+            }
+
+            return level;
+        }
+
+        if (n <= 0 || !(pfd.revents & (POLLERR | POLLHUP | POLLNVAL)))
+        {
+            return rkPressureMonitorCheck(monitor);
+        }
+
+        // The trigger is gone for good (e.g. its cgroup was removed), so
+        // fall back to sleeping instead of returning right away every call
+        close(monitor->triggerFd);
+        monitor->triggerFd = -1;
+    }
+
+    poll(NULL, 0, timeoutMs);
+#elif defined(RK_PRESSURE_PLATFORM_WINDOWS)
+    Sleep((DWORD)timeoutMs);
+#else
+    (void)timeoutMs;
+#endif /* RK_PRESSURE_PLATFORM_XXX */
+
+    return rkPressureMonitorCheck(monitor);
+}
+
+size_t rkPressureReleasedBytes(const rkPressureMonitor *monitor)
+{
+    return monitor->released;
+}
+
+// --- utility functions ------------------------------------------------------
+
+static int rkReadPressure(const char *path, float *some, float *full)
+{
+    FILE *const file = fopen(path, "r");
+    if (!file)
+    {
+        return 0;
+    }
+
+    char line[256];
+    int found = 0;
+    while (fgets(line, sizeof(line), file))
+    {
+        float value = 0.0f;
+        if (sscanf(line, "some avg10=%f", &value) == 1)
+        {
+            *some = value;
+            found = 1;
+        }
+        else if (sscanf(line, "full avg10=%f", &value) == 1)
+        {
+            *full = value;
+            found = 1;
+        }
+    }
+
+    fclose(file);
+    return found;
+}
+
+static void rkDispatchPressure(rkPressureMonitor *monitor, rkPressureLevel level)
+{
+    if (level == RK_PRESSURE_NONE)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < monitor->numWatchers; i++)
+    {
+        const rkPressureWatcher w = monitor->watchers[i];
+        monitor->released += w.callback(w.userData, level);
+    }
+}
+
+static size_t rkTrimArenaUnderPressure(void *userData, rkPressureLevel level)
+{
+    (void)level;
+    return rkArenaRequestTrim((rkArena *)userData);
+}
+
+static size_t rkTrimArenaPoolUnderPressure(void *userData, rkPressureLevel level)
+{
+    (void)level;
+    return rkArenaPoolTrim((rkArenaPool *)userData, 0);
+}
+
+#endif /* RK_PRESSURE_IMPLEMENTATION */
+
+#endif /* RK_PRESSURE_H */
@@ -1,9 +1,1442 @@
 #define RK_ARENA_IMPLEMENTATION
 #include "rkmemory/rkarena.h"
+#define RK_PRESSURE_IMPLEMENTATION
+#include "rkmemory/rkpressure.h"
+#define RK_EXECUTOR_IMPLEMENTATION
+#include "rkmemory/rkexecutor.h"
+#define RK_POOL_IMPLEMENTATION
+#include "rkmemory/rkpool.h"
+#define RK_BUFFER_IMPLEMENTATION
+#include "rkmemory/rkbuffer.h"
 
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <errno.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const char *tempDirectory(void)
+{
+    const char *const dir = getenv("TMPDIR");
+    return dir && *dir ? dir : "/tmp";
+}
+
+static bool createTempFile(char *path, size_t size, const char *name)
+{
+    const int length = snprintf(path, size, "%s/rkarena-%s-XXXXXX", tempDirectory(), name);
+    if (length < 0 || (size_t)length >= size)
+    {
+        return false;
+    }
+
+    const int fd = mkstemp(path);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    close(fd);
+    return true;
+}
+
+static bool writeFakePressure(const char *path, float some, float full)
+{
+    FILE *const file = fopen(path, "w");
+    if (!file)
+    {
+        return false;
+    }
+
+    fprintf(file, "some avg10=%.2f avg60=0.00 avg300=0.00 total=0\n", some);
+    fprintf(file, "full avg10=%.2f avg60=0.00 avg300=0.00 total=0\n", full);
+    fclose(file);
+    return true;
+}
+
+static bool testPressureTrim(void)
+{
+    char path[4096];
+    if (!createTempFile(path, sizeof(path), "pressure"))
+    {
+        fprintf(stderr, "Failed to create the fake pressure file\n");
+        return false;
+    }
+
+    printf("Testing pressure driven trimming...\n");
+    rkArena *const arena = rkCreateArenaWithPageSize(64);
+    rkPressureMonitor *const monitor = rkCreatePressureMonitor(path, 10.0f, 5.0f);
+    if (!arena || !monitor || !rkPressureWatchArena(monitor, arena))
+    {
+        fprintf(stderr, "Failed to set up the pressure monitor\n");
+        rkFreePressureMonitor(monitor);
+        if (arena)
+        {
+            rkFreeArena(arena);
+        }
+        remove(path);
+        return false;
+    }
+
+    for (int i = 0; i < 8; i++)
+    {
+        rkArenaAlloc(arena, 48);
+    }
+    rkResetArena(arena);
+
+    bool ok = writeFakePressure(path, 0.5f, 0.0f);
+    ok = ok && rkPressureMonitorCheck(monitor) == RK_PRESSURE_NONE;
+    ok = ok && rkPressureReleasedBytes(monitor) == 0;
+
+    // The owner releases the cache, and the next check reports it
+    ok = ok && writeFakePressure(path, 25.0f, 1.0f);
+    ok = ok && rkPressureMonitorCheck(monitor) == RK_PRESSURE_SOME;
+    ok = ok && rkPressureReleasedBytes(monitor) == 0;
+
+    rkArenaStats stats;
+    rkResetArena(arena);
+    rkArenaGetStats(arena, &stats);
+    ok = ok && stats.cachedPageCount == 0;
+    ok = ok && rkPressureMonitorCheck(monitor) == RK_PRESSURE_SOME;
+    ok = ok && rkPressureReleasedBytes(monitor) == 7 * 64;
+    ok = ok && rkPressureMonitorArmTrigger(monitor, 150000, 1000000) == 0;
+
+    // Without a trigger, waiting sleeps for the whole timeout
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ok = ok && rkPressureMonitorWait(monitor, 20) == RK_PRESSURE_SOME;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    ok = ok && (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000 >= 20;
+
+    rkFreePressureMonitor(monitor);
+    rkFreeArena(arena);
+    remove(path);
+    return ok;
+}
+
+static bool writeFakeTopology(const char *path, const char *nodes)
+{
+    FILE *const file = fopen(path, "w");
+    if (!file)
+    {
+        return false;
+    }
+
+    fprintf(file, "%s\n", nodes);
+    fclose(file);
+    return true;
+}
+
+static bool testNumaPolicy(void)
+{
+    char path[4096];
+    if (!createTempFile(path, sizeof(path), "node-online"))
+    {
+        fprintf(stderr, "Failed to create the fake topology file\n");
+        return false;
+    }
+
+    printf("Testing NUMA placement...\n");
+    rkArena *const arena = rkCreateArena();
+    if (!arena)
+    {
+        fprintf(stderr, "Failed to allocate arena\n");
+        remove(path);
+        return false;
+    }
+
+    bool ok = writeFakeTopology(path, "0-1,3");
+    rkArenaSetNumaTopology(path);
+    ok = ok && rkArenaNumaNodeCount() == 3;
+    ok = ok && rkArenaSetNumaPolicy(arena, RK_ARENA_NUMA_BIND, 3);
+    ok = ok && !rkArenaSetNumaPolicy(arena, RK_ARENA_NUMA_BIND, 2);
+
+    ok = ok && writeFakeTopology(path, "0");
+    ok = ok && rkArenaNumaNodeCount() == 1;
+    ok = ok && rkArenaSetNumaPolicy(arena, RK_ARENA_NUMA_INTERLEAVE, 0);
+    ok = ok && rkArenaSetNumaPolicy(arena, RK_ARENA_NUMA_FIRST_TOUCH, 0);
+
+    rkArenaSetNumaTopology(NULL);
+    ok = ok && rkArenaNumaNodeCount() >= 1;
+    ok = ok && rkArenaSetNumaPolicy(arena, RK_ARENA_NUMA_BIND, 0);
+    for (int i = 0; i < 4; i++)
+    {
+        ok = ok && rkArenaAllocZeroed(arena, 4096) != NULL;
+    }
+
+    rkFreeArena(arena);
+    remove(path);
+    return ok;
+}
+
+static bool testPrefetch(void)
+{
+    printf("Testing prefetching allocations...\n");
+    rkArena *const arena = rkCreateArenaWithFlags(64 * 1024, RK_ARENA_FLAG_PREFETCH);
+    if (!arena)
+    {
+        fprintf(stderr, "Failed to allocate arena\n");
+        return false;
+    }
+
+    unsigned char *chunks[256];
+    for (int i = 0; i < 256; i++)
+    {
+        chunks[i] = rkArenaAlloc(arena, 500);
+        memset(chunks[i], i, 500);
+    }
+
+    bool ok = true;
+    for (int i = 0; i < 256 && ok; i++)
+    {
+        for (int j = 0; j < 500; j++)
+        {
+            ok = ok && chunks[i][j] == (unsigned char)i;
+        }
+    }
+
+    rkFreeArena(arena);
+    return ok;
+}
+
+static bool testTailReuse(void)
+{
+    printf("Testing page tail reuse...\n");
+    rkArena *const arena = rkCreateArenaWithPageSize(8 * 1024);
+    if (!arena)
+    {
+        fprintf(stderr, "Failed to allocate arena\n");
+        return false;
+    }
+
+    // Each 5KB allocation leaves a 3KB tail, which the 1KB ones should fill
+    bool ok = true;
+    for (int i = 0; i < 4; i++)
+    {
+        ok = ok && rkArenaAlloc(arena, 5 * 1024) != NULL;
+    }
+    for (int i = 0; i < 9; i++)
+    {
+        ok = ok && rkArenaAlloc(arena, 1024) != NULL;
+    }
+
+    rkArenaStats stats;
+    rkArenaGetStats(arena, &stats);
+    ok = ok && stats.pageCount == 4;
+    ok = ok && stats.usedBytes == 29 * 1024;
+    ok = ok && stats.tailReusedBytes == 9 * 1024;
+    ok = ok && stats.wastedBytes == 0;
+    ok = ok && stats.tailFreeBytes == 0;
+
+    rkResetArena(arena);
+    rkArenaGetStats(arena, &stats);
+    ok = ok && stats.pageCount == 1 && stats.cachedPageCount == 3;
+    ok = ok && stats.usedBytes == 0 && stats.tailReusedBytes == 0;
+
+    rkFreeArena(arena);
+    return ok;
+}
+
+static bool testHints(void)
+{
+    printf("Testing lifetime hints...\n");
+    rkArena *const arena = rkCreateArenaWithPageSize(1024);
+    if (!arena)
+    {
+        fprintf(stderr, "Failed to allocate arena\n");
+        return false;
+    }
+
+    unsigned char *const hot = rkArenaAllocHint(arena, 16, RK_HOT);
+    unsigned char *const cold = rkArenaAllocHint(arena, 16, RK_COLD);
+    unsigned char *const hot2 = rkArenaAllocHint(arena, 16, RK_HOT);
+    bool ok = hot && cold && hot2 && hot2 == hot + 16;
+
+    unsigned char *const first = rkArenaAllocHint(arena, 512, RK_SHORT);
+    memset(hot, 0xAB, 16);
+    rkResetArenaHint(arena, RK_SHORT);
+    ok = ok && rkArenaAllocHint(arena, 512, RK_SHORT) == first;
+    ok = ok && hot[15] == 0xAB && rkArenaAllocHint(arena, 16, RK_HOT) == hot2 + 16;
+
+    rkArenaStats stats;
+    rkArenaGetStats(arena, &stats);
+    ok = ok && stats.pageCount == 4;
+
+    rkFreeArena(arena);
+    return ok;
+}
+
+static void *poolChurnThread(void *arg)
+{
+    rkArenaPool *const pool = (rkArenaPool *)arg;
+    for (int i = 0; i < 500; i++)
+    {
+        rkArena *const arena = rkArenaPoolAcquire(pool);
+        if (!arena)
+        {
+            return NULL;
+        }
+
+        rkArenaAlloc(arena, 100);
+        rkArenaPoolRelease(pool, arena);
+    }
+
+    return arg;
+}
+
+static bool testArenaPool(void)
+{
+    printf("Testing arena pools...\n");
+    rkArenaPool *const pool = rkCreateArenaPool(4096, RK_ARENA_FLAG_NONE, 4, 8 * 4096);
+    if (!pool)
+    {
+        fprintf(stderr, "Failed to allocate arena pool\n");
+        return false;
+    }
+
+    rkArena *const a = rkArenaPoolAcquire(pool);
+    rkArena *const b = rkArenaPoolAcquire(pool);
+    rkArena *const c = rkArenaPoolAcquire(pool);
+    bool ok = a && b && c;
+
+    rkArenaStats stats;
+    rkArenaGetStats(a, &stats);
+    ok = ok && stats.pageCount == 1 && stats.cachedPageCount == 3;
+
+    for (int i = 0; i < 10; i++)
+    {
+        ok = ok && rkArenaAlloc(a, 3000) != NULL;
+    }
+
+    // `a` is trimmed back to four pages, and `c` would exceed the cap
+    rkArenaPoolRelease(pool, a);
+    rkArenaPoolRelease(pool, b);
+    rkArenaPoolRelease(pool, c);
+    ok = ok && rkArenaPoolRetainedBytes(pool) == 8 * 4096;
+
+    rkArena *const d = rkArenaPoolAcquire(pool);
+    ok = ok && (d == a || d == b);
+    ok = ok && rkArenaPoolRetainedBytes(pool) == 4 * 4096;
+    rkArenaPoolRelease(pool, d);
+
+    ok = ok && rkArenaPoolTrim(pool, 0) == 8 * 4096;
+    ok = ok && rkArenaPoolRetainedBytes(pool) == 0;
+
+    // Concurrent releases never take the pool past its cap
+    pthread_t threads[8];
+    for (int i = 0; i < 8; i++)
+    {
+        ok = ok && pthread_create(&threads[i], NULL, poolChurnThread, pool) == 0;
+    }
+    for (int i = 0; i < 8; i++)
+    {
+        void *result = NULL;
+        ok = ok && pthread_join(threads[i], &result) == 0 && result == pool;
+    }
+    ok = ok && rkArenaPoolRetainedBytes(pool) <= 8 * 4096;
+
+    rkFreeArenaPool(pool);
+    return ok;
+}
+
+typedef struct SumJob
+{
+    rkExecutor *executor; // The executor to spawn children on
+    int         depth;    // The remaining depth of the task tree
+    long       *total;    // The shared result
+} SumJob;
+
+static void sumTask(rkTask *task, void *userData)
+{
+    SumJob *const job = (SumJob *)userData;
+    rkArena *const arena = rkTaskArena(task);
+
+    int *const values = rkArenaAlloc(arena, sizeof(int) * 100);
+    long sum = 0;
+    for (int i = 0; i < 100; i++)
+    {
+        values[i] = i;
+        sum += values[i];
+    }
+    __atomic_fetch_add(job->total, sum, __ATOMIC_RELAXED);
+
+    for (int i = 0; i < 2 && job->depth > 0; i++)
+    {
+        SumJob *const child = malloc(sizeof(SumJob));
+        *child = (SumJob){ job->executor, job->depth - 1, job->total };
+        rkExecutorSubmit(job->executor, sumTask, child);
+    }
+
+    free(job);
+}
+
+typedef struct SumInput
+{
+    int   values[100]; // The values to sum
+    long *result;      // Where to store the sum
+} SumInput;
+
+static void sumInputTask(rkTask *task, void *userData)
+{
+    // The input lives in the arena handed to the task on submission
+    const SumInput *const input = (const SumInput *)userData;
+    long *const sum = rkArenaAllocZeroed(rkTaskArena(task), sizeof(long));
+    for (int i = 0; i < 100; i++)
+    {
+        *sum += input->values[i];
+    }
+
+    *input->result = *sum;
+}
+
+static bool testExecutor(void)
+{
+    printf("Testing task-scoped arenas...\n");
+    rkExecutor *const executor = rkCreateExecutor(4, NULL);
+    if (!executor)
+    {
+        fprintf(stderr, "Failed to create executor\n");
+        return false;
+    }
+
+    long total = 0;
+    SumJob *const root = malloc(sizeof(SumJob));
+    *root = (SumJob){ executor, 10, &total };
+    bool ok = rkExecutorSubmit(executor, sumTask, root);
+    rkExecutorWait(executor);
+
+    // 2^11 - 1 tasks, each summing 0..99
+    ok = ok && total == 2047L * 4950L;
+
+    long result = 0;
+    rkArena *const arena = rkExecutorAcquireArena(executor);
+    SumInput *const input = rkArenaAlloc(arena, sizeof(SumInput));
+    for (int i = 0; i < 100; i++)
+    {
+        input->values[i] = i;
+    }
+    input->result = &result;
+
+    ok = ok && rkExecutorSubmitWithArena(executor, sumInputTask, input, arena);
+    rkExecutorWait(executor);
+    ok = ok && result == 4950L;
+
+    rkFreeExecutor(executor);
+    return ok;
+}
+
+static bool testOwns(void)
+{
+    printf("Testing pointer ownership...\n");
+    rkArena *const arena = rkCreateArenaWithPageSize(1024);
+    rkArena *const other = rkCreateArenaWithPageSize(1024);
+    if (!arena || !other)
+    {
+        fprintf(stderr, "Failed to allocate arena\n");
+        return false;
+    }
+
+    // Enough pages to grow the index beyond its first OS page
+    unsigned char *ptrs[1200];
+    bool ok = true;
+    for (size_t i = 0; i < 1200; i++)
+    {
+        ptrs[i] = rkArenaAlloc(arena, i % 7 == 0 ? 3000 : 700);
+        ok = ok && ptrs[i];
+    }
+
+    for (size_t i = 0; ok && i < 1200; i++)
+    {
+        ok = rkArenaOwns(arena, ptrs[i]) && rkArenaOwns(arena, ptrs[i] + 699) && !rkArenaOwns(other, ptrs[i]);
+    }
+
+    int *const heap = malloc(sizeof(int));
+    ok = ok && !rkArenaOwns(arena, heap) && !rkArenaOwns(arena, NULL);
+    free(heap);
+
+    // Unallocated bytes of the current page are not owned
+    unsigned char *const last = rkArenaAlloc(other, 16);
+    ok = ok && rkArenaOwns(other, last + 15) && !rkArenaOwns(other, last + 16);
+
+    rkResetArena(arena);
+    ok = ok && !rkArenaOwns(arena, ptrs[1199]);
+
+    rkFreeArena(other);
+    rkFreeArena(arena);
+    return ok;
+}
+
+static bool testPageRefcounts(void)
+{
+    printf("Testing per-page reference counts...\n");
+    rkArena *const arena = rkCreateArenaWithFlags(1024, RK_ARENA_FLAG_REFCOUNT);
+    if (!arena)
+    {
+        fprintf(stderr, "Failed to allocate arena\n");
+        return false;
+    }
+
+    // One 600 byte allocation per page
+    unsigned char *const a = rkArenaAlloc(arena, 600);
+    unsigned char *const b = rkArenaAlloc(arena, 600);
+    unsigned char *const c = rkArenaAlloc(arena, 600);
+    unsigned char *const d = rkArenaAlloc(arena, 100);
+    bool ok = a && b && c && d;
+
+    rkArenaStats stats;
+    rkArenaGetStats(arena, &stats);
+    ok = ok && stats.pageCount == 3;
+
+    // The tail of the first page served `d`, so it is only freed with it
+    rkArenaRelease(arena, a);
+    rkArenaGetStats(arena, &stats);
+    ok = ok && stats.pageCount == 3 && stats.cachedPageCount == 0;
+
+    rkArenaRelease(arena, d);
+    rkArenaGetStats(arena, &stats);
+    ok = ok && stats.pageCount == 2 && stats.cachedPageCount == 1;
+
+    // The current page is rewound in place
+    rkArenaRelease(arena, c);
+    ok = ok && rkArenaAlloc(arena, 600) == c;
+
+    // Reallocating releases the old region
+    unsigned char *const e = rkArenaRealloc(arena, b, 600, 700);
+    rkArenaGetStats(arena, &stats);
+    ok = ok && e && stats.pageCount == 2 && stats.cachedPageCount == 1;
+
+    rkFreeArena(arena);
+    return ok;
+}
+
+static bool testLargeRealloc(void)
+{
+    printf("Testing large block growth...\n");
+    rkArena *const arena = rkCreateArenaWithPageSize(4096);
+    if (!arena)
+    {
+        fprintf(stderr, "Failed to allocate arena\n");
+        return false;
+    }
+
+    const size_t oldSize = 1024 * 1024;
+    const size_t newSize = 64 * 1024 * 1024;
+    unsigned char *const small = rkArenaAlloc(arena, 16);
+    unsigned char *const block = rkArenaAlloc(arena, oldSize);
+    bool ok = small && block;
+    for (size_t i = 0; ok && i < oldSize; i += 4096)
+    {
+        block[i] = (unsigned char)(i / 4096);
+    }
+
+    unsigned char *const grown = rkArenaRealloc(arena, block, oldSize, newSize);
+    ok = ok && grown;
+    for (size_t i = 0; ok && i < oldSize; i += 4096)
+    {
+        ok = grown[i] == (unsigned char)(i / 4096);
+    }
+
+    // The block was grown in place in the chain, not copied to a new page
+    rkArenaStats stats;
+    rkArenaGetStats(arena, &stats);
+    ok = ok && stats.pageCount == 2 && stats.usedBytes == 16 + newSize;
+    ok = ok && rkArenaAlloc(arena, 16) == small + 16;
+
+    rkFreeArena(arena);
+    return ok;
+}
+
+static bool testReserveSlices(void)
+{
+    printf("Testing slice reservation...\n");
+    rkArena *const arena = rkCreateArenaWithPageSize(1024);
+    if (!arena)
+    {
+        fprintf(stderr, "Failed to allocate arena\n");
+        return false;
+    }
+
+    // 1612 bytes in total, more than a page
+    const size_t counts[4] = { 3, 0, 100, 300 };
+    int *slices[4];
+    bool ok = rkArenaReserveSlices(arena, counts, 4, sizeof(int), (void **)slices);
+    ok = ok && slices[1] == slices[0] + 3 && slices[2] == slices[1] && slices[3] == slices[2] + 100;
+    for (size_t s = 0; ok && s < 4; s++)
+    {
+        for (size_t i = 0; i < counts[s]; i++)
+        {
+            slices[s][i] = (int)(s * 1000 + i);
+        }
+    }
+    ok = ok && slices[0][2] == 2 && slices[2][0] == 2000 && slices[3][299] == 3299;
+
+    // The current page keeps its free space for small allocations
+    unsigned char *const small = rkArenaAlloc(arena, 16);
+    ok = ok && rkArenaAlloc(arena, 16) == small + 16;
+
+    rkArenaStats stats;
+    rkArenaGetStats(arena, &stats);
+    ok = ok && stats.pageCount == 2 && stats.usedBytes == 1612 + 32;
+
+    rkResetArena(arena);
+    rkArenaGetStats(arena, &stats);
+    ok = ok && stats.pageCount == 1 && stats.cachedPageCount == 0;
+
+    const size_t none[2] = { 0, 0 };
+    ok = ok && rkArenaReserveSlices(arena, none, 2, sizeof(int), (void **)slices) && !slices[0] && !slices[1];
+
+    rkFreeArena(arena);
+    return ok;
+}
+
+static bool testAbsorb(void)
+{
+    printf("Testing arena absorption...\n");
+    rkArena *const dst = rkCreateArenaWithPageSize(1024);
+    rkArena *const src = rkCreateArenaWithPageSize(1024);
+    if (!dst || !src)
+    {
+        fprintf(stderr, "Failed to allocate arena\n");
+        return false;
+    }
+
+    unsigned char *const kept = rkArenaAlloc(dst, 16);
+    unsigned char *const moved[3] = {
+        rkArenaAlloc(src, 900),
+        rkArenaAlloc(src, 900),
+        rkArenaAllocHint(src, 2048, RK_COLD)
+    };
+    memset(moved[0], 0x11, 900);
+    memset(moved[2], 0x22, 2048);
+
+    bool ok = rkArenaAbsorb(dst, src);
+    ok = ok && rkArenaOwns(dst, moved[1]) && rkArenaOwns(dst, moved[2]) && !rkArenaOwns(src, moved[0]);
+
+    rkArenaStats stats;
+    rkArenaGetStats(src, &stats);
+    ok = ok && stats.pageCount == 0 && stats.usedBytes == 0;
+
+    rkArenaGetStats(dst, &stats);
+    ok = ok && stats.pageCount == 4 && stats.usedBytes == 16 + 1800 + 2048;
+
+    // The free space of the absorbed pages is reused before `dst` maps more
+    ok = ok && rkArenaAlloc(dst, 100) && rkArenaAlloc(dst, 100) && rkArenaAlloc(dst, 900) == kept + 16;
+    rkArenaGetStats(dst, &stats);
+    ok = ok && stats.pageCount == 4 && stats.tailReusedBytes == 200;
+
+    // `src` can be used again and does not touch the absorbed memory
+    unsigned char *const fresh = rkArenaAlloc(src, 900);
+    ok = ok && fresh && fresh != moved[0] && fresh != moved[1];
+    memset(fresh, 0x33, 900);
+    rkFreeArena(src);
+    ok = ok && moved[0][899] == 0x11 && moved[2][2047] == 0x22;
+
+    rkResetArena(dst);
+    rkArenaGetStats(dst, &stats);
+    ok = ok && stats.pageCount == 1 && stats.cachedPageCount == 2;
+
+    // Interleaved pages of both arenas are found through the merged index
+    rkArena *const other = rkCreateArenaWithPageSize(1024);
+    unsigned char *ptrs[64];
+    ok = ok && other;
+    for (size_t i = 0; ok && i < 64; i++)
+    {
+        ptrs[i] = rkArenaAlloc(i % 2 ? other : dst, 1000);
+        ok = ptrs[i] != NULL;
+    }
+    ok = ok && rkArenaAbsorb(dst, other);
+    for (size_t i = 0; ok && i < 64; i++)
+    {
+        ok = rkArenaOwns(dst, ptrs[i]) && rkArenaOwns(dst, ptrs[i] + 999);
+    }
+    if (other)
+    {
+        rkFreeArena(other);
+    }
+
+    // Arenas with different page sizes or alignment guarantees are refused
+    rkArena *const plain = rkCreateArenaWithPageSize(4096);
+    rkArena *const direct = rkCreateArenaWithFlags(4096, RK_ARENA_FLAG_DIRECT_IO);
+    if (plain && direct)
+    {
+        ok = ok && rkArenaAlloc(plain, 16) && rkArenaAlloc(direct, 16);
+        ok = ok && !rkArenaAbsorb(dst, plain) && !rkArenaAbsorb(direct, plain);
+        ok = ok && !rkArenaAbsorb(plain, direct);
+        rkArenaGetStats(plain, &stats);
+        ok = ok && stats.pageCount == 1 && stats.usedBytes == 16;
+    }
+    else
+    {
+        ok = false;
+    }
+
+    if (plain)
+    {
+        rkFreeArena(plain);
+    }
+    if (direct)
+    {
+        rkFreeArena(direct);
+    }
+
+    rkFreeArena(dst);
+    return ok;
+}
+
+typedef struct RemoteFree
+{
+    rkPool *pool;
+    void  **objects;
+    size_t  count;
+} RemoteFree;
+
+static void *remoteFreeThread(void *arg)
+{
+    RemoteFree *const job = arg;
+    for (size_t i = 0; i < job->count; i++)
+    {
+        rkPoolFree(job->pool, job->objects[i]);
+    }
+
+    return NULL;
+}
+
+static void *poolUserThread(void *arg)
+{
+    rkPool *const pool = arg;
+    void *const object = rkPoolAlloc(pool);
+    rkPoolFree(pool, object);
+    return object;
+}
+
+static bool testPoolRemoteFree(void)
+{
+    printf("Testing object pool remote frees...\n");
+    rkPool *const pool = rkCreatePool(48, 256);
+    if (!pool)
+    {
+        fprintf(stderr, "Failed to create pool\n");
+        return false;
+    }
+
+    void *objects[1000];
+    bool ok = true;
+    for (size_t i = 0; i < 1000; i++)
+    {
+        objects[i] = rkPoolAlloc(pool);
+        ok = ok && objects[i] && ((uintptr_t)objects[i] & 15) == 0;
+    }
+
+    rkPoolStats stats;
+    rkPoolGetStats(pool, &stats);
+    const size_t carved = stats.carvedObjects;
+
+    // Another thread frees everything, which the owner should reclaim rather
+    // than carving new objects
+    RemoteFree job = { pool, objects, 1000 };
+    pthread_t thread;
+    ok = ok && pthread_create(&thread, NULL, remoteFreeThread, &job) == 0 && pthread_join(thread, NULL) == 0;
+    for (size_t i = 0; i < 1000; i++)
+    {
+        objects[i] = rkPoolAlloc(pool);
+        ok = ok && objects[i];
+    }
+
+    rkPoolGetStats(pool, &stats);
+    ok = ok && stats.carvedObjects == carved;
+    ok = ok && stats.remoteFrees == 1000 && stats.remoteReclaimed == 1000;
+
+    // The heap of an exited thread is adopted by the next one
+    void *first = NULL;
+    void *second = NULL;
+    ok = ok && pthread_create(&thread, NULL, poolUserThread, pool) == 0 && pthread_join(thread, &first) == 0;
+    ok = ok && pthread_create(&thread, NULL, poolUserThread, pool) == 0 && pthread_join(thread, &second) == 0;
+    rkPoolGetStats(pool, &stats);
+    ok = ok && first && first == second && stats.heapCount == 2;
+
+    rkFreePool(pool);
+    return ok;
+}
+
+static bool testBufferSlices(void)
+{
+    printf("Testing refcounted buffer slices...\n");
+    rkBufferPool *const pool = rkCreateBufferPool(256);
+    if (!pool)
+    {
+        fprintf(stderr, "Failed to create buffer pool\n");
+        return false;
+    }
+
+    // Fan a message out to three subscribers without copying it
+    rkBufferSlice message = rkBufferAlloc(pool, 100);
+    bool ok = message.data != NULL;
+    memset(message.data, 0x5A, message.size);
+
+    rkBufferSlice subscribers[3];
+    for (int i = 0; i < 3; i++)
+    {
+        subscribers[i] = rkBufferRetain(message);
+    }
+    rkBufferRelease(message);
+
+    rkBufferSlice header = rkBufferSubSlice(subscribers[0], 10, 20);
+    ok = ok && header.data == subscribers[0].data + 10 && header.size == 20;
+
+    // Moving on to a new page keeps the old one alive for its slices
+    rkBufferSlice other = rkBufferAlloc(pool, 200);
+    rkBufferPoolStats stats;
+    rkBufferPoolGetStats(pool, &stats);
+    ok = ok && other.data && stats.pageCount == 2 && stats.freePageCount == 0;
+
+    for (int i = 0; i < 3; i++)
+    {
+        ok = ok && subscribers[i].data[99] == 0x5A;
+        rkBufferRelease(subscribers[i]);
+    }
+    rkBufferPoolGetStats(pool, &stats);
+    ok = ok && stats.freePageCount == 0;
+
+    rkBufferRelease(header);
+    rkBufferPoolGetStats(pool, &stats);
+    ok = ok && stats.freePageCount == 1;
+
+    // The released page is reused instead of allocating a third one
+    rkBufferRelease(other);
+    rkBufferSlice next = rkBufferAlloc(pool, 200);
+    rkBufferPoolGetStats(pool, &stats);
+    ok = ok && next.data && stats.pageCount == 2 && stats.recycledPages == 1;
+    rkBufferRelease(next);
+
+    rkBufferSlice large = rkBufferAlloc(pool, 1000);
+    ok = ok && large.data && large.size == 1000;
+    rkBufferRelease(large);
+
+    rkFreeBufferPool(pool);
+    return ok;
+}
+
+static bool testDirectRead(void)
+{
+    printf("Testing direct I/O file reads...\n");
+    char path[4096];
+    FILE *const file = createTempFile(path, sizeof(path), "direct-read") ? fopen(path, "wb") : NULL;
+    if (!file)
+    {
+        fprintf(stderr, "Failed to write the direct read fixture\n");
+        return false;
+    }
+
+    for (size_t i = 0; i < 10000; i++)
+    {
+        fputc((int)(i * 7 % 251), file);
+    }
+    fclose(file);
+
+    rkArena *const arena = rkCreateArenaWithFlags(6000, RK_ARENA_FLAG_DIRECT_IO);
+    if (!arena)
+    {
+        fprintf(stderr, "Failed to allocate arena\n");
+        remove(path);
+        return false;
+    }
+
+    // Sizes are rounded up to whole blocks, so allocations stay block aligned
+    unsigned char *const a = rkArenaAlloc(arena, 100);
+    unsigned char *const b = rkArenaAlloc(arena, 100);
+    bool ok = a && b == a + 4096 && (uintptr_t)a % 4096 == 0;
+
+    size_t size = 0;
+    unsigned char *const data = rkArenaReadFile(arena, path, &size);
+    ok = ok && data && size == 10000 && (uintptr_t)data % 4096 == 0;
+    for (size_t i = 0; ok && i < size; i++)
+    {
+        ok = data[i] == i * 7 % 251;
+    }
+
+    // Missing files fail cleanly
+    remove(path);
+    ok = ok && rkArenaReadFile(arena, path, &size) == NULL;
+
+    rkFreeArena(arena);
+    return ok;
+}
+
+static bool testMapFile(void)
+{
+    printf("Testing file mappings...\n");
+    char path[4096];
+    FILE *const file = createTempFile(path, sizeof(path), "mapped-file") ? fopen(path, "wb") : NULL;
+    if (!file)
+    {
+        fprintf(stderr, "Failed to write the mapped file fixture\n");
+        return false;
+    }
+
+    fputs("key=value\n", file);
+    fclose(file);
+
+    rkArena *const arena = rkCreateArenaWithPageSize(1024);
+    if (!arena)
+    {
+        fprintf(stderr, "Failed to allocate arena\n");
+        remove(path);
+        return false;
+    }
+
+    size_t size = 0;
+    const char *const data = rkArenaMapFile(arena, path, &size);
+    bool ok = data && size == 10 && memcmp(data, "key=value\n", 10) == 0;
+    ok = ok && rkArenaOwns(arena, data + 9);
+
+    // Parser output shares the lifetime of the mapping
+    const char **const value = rkArenaAlloc(arena, sizeof(const char *));
+    *value = data + 4;
+    ok = ok && **value == 'v';
+
+    rkArenaStats stats;
+    rkArenaGetStats(arena, &stats);
+    ok = ok && stats.pageCount == 2 && stats.usedBytes == 10 + sizeof(const char *);
+
+    // The mapping is unmapped rather than cached
+    rkResetArena(arena);
+    rkArenaGetStats(arena, &stats);
+    ok = ok && stats.pageCount == 1 && stats.cachedPageCount == 0 && !rkArenaOwns(arena, data);
+
+    remove(path);
+    ok = ok && rkArenaMapFile(arena, path, &size) == NULL;
+
+    rkFreeArena(arena);
+    return ok;
+}
+
+static bool testWritev(void)
+{
+    printf("Testing scatter-gather writes...\n");
+    rkArena *const arena = rkCreateArenaWithPageSize(64);
+    int fds[2];
+    if (!arena || pipe(fds) != 0)
+    {
+        fprintf(stderr, "Failed to set up the arena and pipe\n");
+        return false;
+    }
+
+    // A response assembled from pieces spread over several pages
+    const char *const parts[] = { "HTTP/1.1 200 OK\r\n", "Content-Length: 5\r\n\r\n", "", "hello" };
+    rkArenaRegion regions[4];
+    size_t total = 0;
+    for (size_t i = 0; i < 4; i++)
+    {
+        const size_t size = strlen(parts[i]);
+        char *const data = rkArenaAlloc(arena, size + 1);
+        memcpy(data, parts[i], size);
+        regions[i].data = data;
+        regions[i].size = size;
+        total += size;
+    }
+
+    char expected[64];
+    snprintf(expected, sizeof(expected), "%s%s%s", parts[0], parts[1], parts[3]);
+
+    char received[64] = { 0 };
+    bool ok = rkArenaWritev(arena, fds[1], regions, 4, RK_ARENA_WRITE_NONE) == total;
+    ok = ok && read(fds[0], received, sizeof(received)) == (ssize_t)total && memcmp(received, expected, total) == 0;
+
+    memset(received, 0, sizeof(received));
+    ok = ok && rkArenaWritev(arena, fds[1], regions, 4, RK_ARENA_WRITE_GIFT) == total;
+    ok = ok && read(fds[0], received, sizeof(received)) == (ssize_t)total && memcmp(received, expected, total) == 0;
+
+    close(fds[0]);
+    close(fds[1]);
+    rkFreeArena(arena);
+    return ok;
+}
+
+static bool testIngest(void)
+{
+    printf("Testing reads into arena memory...\n");
+    rkArena *const arena = rkCreateArenaWithPageSize(128);
+    int fds[2];
+    int socks[2];
+    if (!arena || pipe(fds) != 0 || socketpair(AF_UNIX, SOCK_STREAM, 0, socks) != 0)
+    {
+        fprintf(stderr, "Failed to set up the arena, pipe and sockets\n");
+        return false;
+    }
+
+    unsigned char *const first = rkArenaAlloc(arena, 8);
+
+    // Only the bytes actually read are committed
+    size_t numRead = 0;
+    bool ok = write(fds[1], "0123456789", 10) == 10;
+    char *const a = rkArenaRead(arena, fds[0], 64, &numRead);
+    ok = ok && a == (char *)first + 8 && numRead == 10 && memcmp(a, "0123456789", 10) == 0;
+    ok = ok && rkArenaAlloc(arena, 4) == (unsigned char *)a + 10;
+
+    // Too little room left in the current page moves on to a new one
+    ok = ok && send(socks[1], "hello", 5, 0) == 5;
+    char *const b = rkArenaRecv(arena, socks[0], 120, 0, &numRead);
+    ok = ok && b && numRead == 5 && memcmp(b, "hello", 5) == 0 && rkArenaOwns(arena, b);
+
+    rkArenaStats stats;
+    rkArenaGetStats(arena, &stats);
+    ok = ok && stats.pageCount == 2 && stats.usedBytes == 8 + 10 + 4 + 5;
+
+    // More than a page goes to a dedicated page
+    ok = ok && write(fds[1], "large", 5) == 5;
+    char *const c = rkArenaRead(arena, fds[0], 1000, &numRead);
+    ok = ok && c && numRead == 5 && memcmp(c, "large", 5) == 0;
+
+    close(fds[1]);
+    ok = ok && rkArenaRead(arena, fds[0], 64, &numRead) && numRead == 0;
+    close(fds[0]);
+    ok = ok && !rkArenaRead(arena, fds[0], 64, &numRead);
+
+    close(socks[0]);
+    close(socks[1]);
+    rkFreeArena(arena);
+    return ok;
+}
+
+static bool testForkFlags(void)
+{
+    printf("Testing fork-aware mappings...\n");
+    rkArena *const wiped = rkCreateArenaWithFlags(4096, RK_ARENA_FLAG_WIPEONFORK | RK_ARENA_FLAG_NO_COLORING);
+    rkArena *const kept = rkCreateArenaWithFlags(4096, RK_ARENA_FLAG_DONTFORK | RK_ARENA_FLAG_NO_COLORING);
+    if (!wiped || !kept)
+    {
+        fprintf(stderr, "Failed to allocate arena\n");
+        return false;
+    }
+
+    unsigned char *const a = rkArenaAlloc(wiped, 4096);
+    unsigned char *const b = rkArenaAlloc(kept, 4096);
+    memset(a, 0x5A, 4096);
+    memset(b, 0x5A, 4096);
+
+    // The child sees zeroes in place of the first arena and nothing at all
+    // in place of the second
+    const pid_t pid = fork();
+    if (pid == 0)
+    {
+        const bool unmapped = msync(b, 4096, MS_ASYNC) == -1 && errno == ENOMEM;
+        _exit(a[0] == 0 && a[4095] == 0 && unmapped ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    int status = 0;
+    bool ok = pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+    ok = ok && a[0] == 0x5A && b[4095] == 0x5A;
+
+    rkFreeArena(wiped);
+    rkFreeArena(kept);
+    return ok;
+}
+
+static bool testFreeze(void)
+{
+    printf("Testing frozen arenas...\n");
+    rkArena *const arena = rkCreateArenaWithPageSize(4096);
+    if (!arena)
+    {
+        fprintf(stderr, "Failed to allocate arena\n");
+        return false;
+    }
+
+    // A reference table that identical workers could share
+    unsigned *const table = rkArenaAlloc(arena, 4096);
+    for (unsigned i = 0; i < 1024; i++)
+    {
+        table[i] = i * i;
+    }
+
+    bool ok = rkArenaFreeze(arena, 1) && table[1023] == 1023u * 1023u;
+    ok = ok && rkArenaAlloc(arena, 16) == NULL;
+
+    // The stats are only available on kernels that report merging per process
+    rkArenaKsmStats stats;
+    const int ksmAvailable = access("/proc/self/ksm_merging_pages", R_OK) == 0;
+    ok = ok && rkArenaGetKsmStats(&stats) == ksmAvailable;
+    ok = ok && (ksmAvailable ? stats.mergingPages >= 0 : stats.mergingPages == -1);
+
+    // Writing to a frozen page faults
+    const pid_t child = fork();
+    if (child == 0)
+    {
+        signal(SIGSEGV, SIG_DFL);
+        table[0] = 1;
+        _exit(EXIT_SUCCESS);
+    }
+
+    int status = 0;
+    ok = ok && child > 0 && waitpid(child, &status, 0) == child;
+    ok = ok && WIFSIGNALED(status) && WTERMSIG(status) == SIGSEGV;
+    ok = ok && table[0] == 0;
+
+    // Resetting thaws the pages, so they can be written again
+    rkResetArena(arena);
+    unsigned *const scratch = rkArenaAlloc(arena, 4096);
+    ok = ok && scratch == table;
+    scratch[0] = 42;
+
+    rkFreeArena(arena);
+    return ok;
+}
+
+static bool testColdCompression(void)
+{
+    printf("Testing cold page compression...\n");
+    rkArena *const arena = rkCreateArenaWithFlags(64 * 1024, RK_ARENA_FLAG_COMPRESS);
+    if (!arena)
+    {
+        fprintf(stderr, "Failed to allocate arena\n");
+        return false;
+    }
+
+    // A rarely accessed table with plenty of redundancy
+    unsigned *const table = rkArenaAlloc(arena, 48 * 1024);
+    for (unsigned i = 0; i < 12 * 1024; i++)
+    {
+        table[i] = i % 100;
+    }
+    unsigned *const large = rkArenaAlloc(arena, 256 * 1024);
+    for (unsigned i = 0; i < 64 * 1024; i++)
+    {
+        large[i] = i / 64;
+    }
+
+    // The first scan arms the pages, the second compresses those still cold
+    bool ok = rkArenaCompressCold(arena, 0) == 0;
+    ok = ok && rkArenaCompressCold(arena, 0) > 200 * 1024;
+
+    rkArenaStats stats;
+    rkArenaGetStats(arena, &stats);
+    ok = ok && stats.packedPageCount == 2 && stats.packedBytes < 100 * 1024;
+    ok = ok && stats.usedBytes == 48 * 1024 + 256 * 1024;
+
+    // Accessing a page restores it, and allocating does not disturb others
+    ok = ok && table[12 * 1024 - 1] == (12 * 1024 - 1) % 100 && table[0] == 0;
+    unsigned *const more = rkArenaAlloc(arena, 1024);
+    more[0] = 7;
+    rkArenaGetStats(arena, &stats);
+    ok = ok && stats.packedPageCount == 1;
+
+    ok = ok && large[64 * 1024 - 1] == 1023 && large[100] == 1;
+    rkArenaGetStats(arena, &stats);
+    ok = ok && stats.packedPageCount == 0;
+
+    // Touched pages are re-armed rather than compressed
+    rkArenaCompressCold(arena, 0);
+    table[5] = 500;
+    rkArenaCompressCold(arena, 0);
+    rkArenaGetStats(arena, &stats);
+    ok = ok && stats.packedPageCount == 1 && table[5] == 500 && large[64] == 1;
+
+    // Memory handed to the kernel is restored before the syscall
+    int fds[2];
+    ok = ok && pipe(fds) == 0;
+    rkArenaCompressCold(arena, 0);
+    rkArenaCompressCold(arena, 0);
+    rkArenaRegion region = { large, 64 };
+    unsigned copy[16] = { 0 };
+    ok = ok && rkArenaWritev(arena, fds[1], &region, 1, RK_ARENA_WRITE_NONE) == 64;
+    ok = ok && read(fds[0], copy, sizeof(copy)) == sizeof(copy) && copy[15] == 0;
+    close(fds[0]);
+    close(fds[1]);
+
+    rkResetArena(arena);
+    rkArenaGetStats(arena, &stats);
+    ok = ok && stats.packedPageCount == 0;
+    unsigned *const fresh = rkArenaAlloc(arena, 16);
+    fresh[0] = 1;
+
+    rkFreeArena(arena);
+    return ok;
+}
+
+typedef struct ColdToucher
+{
+    unsigned *data;    // The block the thread checks and writes
+    size_t    count;   // The number of elements in the block
+    unsigned  pauseUs; // How long the thread sleeps between rounds
+    int       stop;    // Set by the owner once it is done
+    int       ok;      // Cleared if the block was ever seen corrupt
+} ColdToucher;
+
+static void *coldTouchThread(void *arg)
+{
+    ColdToucher *const job = arg;
+    for (unsigned round = 1; !__atomic_load_n(&job->stop, __ATOMIC_ACQUIRE); round++)
+    {
+        for (size_t i = 0; i < job->count; i++)
+        {
+            if (job->data[i] != (unsigned)i / 64 + round - 1)
+            {
+                job->ok = 0;
+                return NULL;
+            }
+
+            job->data[i]++;
+        }
+
+        // Pausing lets the owner pack the block between rounds
+        if (job->pauseUs)
+        {
+            usleep(job->pauseUs);
+        }
+    }
+
+    return NULL;
+}
+
+static bool testColdConcurrency(void)
+{
+    printf("Testing cold pages touched by other threads...\n");
+    rkArena *const arena = rkCreateArenaWithFlags(64 * 1024, RK_ARENA_FLAG_COMPRESS);
+    if (!arena)
+    {
+        fprintf(stderr, "Failed to allocate arena\n");
+        return false;
+    }
+
+    ColdToucher jobs[4];
+    for (size_t t = 0; t < 4; t++)
+    {
+        jobs[t].data = rkArenaAlloc(arena, 64 * 1024);
+        jobs[t].count = 16 * 1024;
+        jobs[t].pauseUs = 100;
+        jobs[t].stop = 0;
+        jobs[t].ok = 1;
+        for (size_t i = 0; i < jobs[t].count; i++)
+        {
+            jobs[t].data[i] = (unsigned)i / 64;
+        }
+    }
+
+    bool ok = true;
+    pthread_t threads[4];
+    for (size_t t = 0; t < 4; t++)
+    {
+        ok = ok && pthread_create(&threads[t], NULL, coldTouchThread, &jobs[t]) == 0;
+    }
+
+    // The owner keeps packing the blocks and growing the page table while
+    // the threads fault on them
+    size_t released = 0;
+    for (int round = 0; ok && round < 200; round++)
+    {
+        rkArenaCompressCold(arena, 0);
+        released += rkArenaCompressCold(arena, 0);
+        ok = rkArenaAlloc(arena, 60 * 1024) != NULL;
+    }
+    ok = ok && released > 0;
+
+    for (size_t t = 0; t < 4; t++)
+    {
+        __atomic_store_n(&jobs[t].stop, 1, __ATOMIC_RELEASE);
+    }
+    for (size_t t = 0; t < 4; t++)
+    {
+        ok = ok && pthread_join(threads[t], NULL) == 0 && jobs[t].ok;
+    }
+
+    rkFreeArena(arena);
+    return ok;
+}
+
+static bool testCompressLimit(void)
+{
+    printf("Testing the limit on compressed arenas...\n");
+
+    // Creating more compressed arenas than the fault handler can track fails
+    // instead of silently dropping the flag
+    rkArena *arenas[65];
+    size_t created = 0;
+    while (created < 65)
+    {
+        arenas[created] = rkCreateArenaWithFlags(4096, RK_ARENA_FLAG_COMPRESS);
+        if (!arenas[created])
+        {
+            break;
+        }
+
+        created++;
+    }
+    bool ok = created == 64;
+
+    // Freeing one makes room for another
+    if (created > 0)
+    {
+        rkFreeArena(arenas[--created]);
+        arenas[created] = rkCreateArenaWithFlags(4096, RK_ARENA_FLAG_COMPRESS);
+        ok = ok && arenas[created] != NULL;
+        created += arenas[created] != NULL;
+    }
+
+    while (created > 0)
+    {
+        rkFreeArena(arenas[--created]);
+    }
+
+    return ok;
+}
+
+static bool testSpillConcurrency(void)
+{
+    printf("Testing spilled pages written by other threads...\n");
+
+    // A write only gets lost if it lands while a block is being spilled, so
+    // the whole scenario runs a few times
+    bool ok = true;
+    for (int attempt = 0; ok && attempt < 4; attempt++)
+    {
+        rkArena *const arena = rkCreateArenaWithFlags(64 * 1024, RK_ARENA_FLAG_COMPRESS);
+        if (!arena)
+        {
+            fprintf(stderr, "Failed to allocate arena\n");
+            return false;
+        }
+
+        ColdToucher jobs[4];
+        for (size_t t = 0; t < 4; t++)
+        {
+            jobs[t].data = rkArenaAlloc(arena, 4 * 1024 * 1024);
+            jobs[t].count = 1024 * 1024;
+            jobs[t].pauseUs = 0;
+            jobs[t].stop = 0;
+            jobs[t].ok = 1;
+            for (size_t i = 0; i < jobs[t].count; i++)
+            {
+                jobs[t].data[i] = (unsigned)i / 64;
+            }
+        }
+
+        // Filling the first page maps another one after the blocks, which
+        // makes the last block a spill candidate too
+        ok = rkArenaAlloc(arena, 60 * 1024) != NULL && rkArenaAlloc(arena, 60 * 1024) != NULL;
+        pthread_t threads[4];
+        for (size_t t = 0; t < 4; t++)
+        {
+            ok = ok && pthread_create(&threads[t], NULL, coldTouchThread, &jobs[t]) == 0;
+        }
+
+        // Lowering the budget spills one block at a time while the threads
+        // keep writing to them, as the blocks are the least recently used
+        for (size_t left = 4; ok && left-- > 0; )
+        {
+            ok = rkArenaSetSpill(arena, tempDirectory(), left * 4 * 1024 * 1024 + 1024 * 1024);
+        }
+
+        rkArenaStats stats;
+        rkArenaGetStats(arena, &stats);
+        ok = ok && stats.spilledPageCount >= 4;
+
+        // Give the threads a few rounds on the file before checking them
+        usleep(10000);
+        for (size_t t = 0; t < 4; t++)
+        {
+            __atomic_store_n(&jobs[t].stop, 1, __ATOMIC_RELEASE);
+        }
+        for (size_t t = 0; t < 4; t++)
+        {
+            ok = ok && pthread_join(threads[t], NULL) == 0 && jobs[t].ok;
+        }
+
+        rkFreeArena(arena);
+    }
+
+    return ok;
+}
+
+static bool testSpill(void)
+{
+    printf("Testing spilling to a file...\n");
+    rkArena *const arena = rkCreateArenaWithPageSize(4096);
+    if (!arena)
+    {
+        fprintf(stderr, "Failed to allocate arena\n");
+        return false;
+    }
+
+    bool ok = rkArenaSetSpill(arena, tempDirectory(), 4 * 4096);
+
+    // Fill many more pages than the budget holds
+    unsigned char *blocks[32];
+    for (size_t i = 0; ok && i < 32; i++)
+    {
+        blocks[i] = rkArenaAlloc(arena, 4000);
+        ok = blocks[i] != NULL;
+        if (ok)
+        {
+            memset(blocks[i], (int)i + 1, 4000);
+        }
+    }
+
+    rkArenaStats stats;
+    rkArenaGetStats(arena, &stats);
+    ok = ok && stats.spilledPageCount >= 24 && stats.spilledBytes == stats.spilledPageCount * 4096;
+
+    // Spilled pages keep their addresses and contents, and stay writable
+    for (size_t i = 0; ok && i < 32; i++)
+    {
+        ok = blocks[i][0] == i + 1 && blocks[i][3999] == i + 1;
+    }
+    if (ok)
+    {
+        blocks[0][0] = 0xAA;
+        ok = blocks[0][0] == 0xAA;
+    }
+
+    // A source with spilled pages cannot be absorbed
+    rkArena *const dst = rkCreateArenaWithPageSize(4096);
+    ok = ok && dst && !rkArenaAbsorb(dst, arena);
+    rkFreeArena(dst);
+
+    rkResetArena(arena);
+    rkArenaGetStats(arena, &stats);
+    ok = ok && stats.spilledPageCount == 0 && stats.spilledBytes == 0;
+
+    // Spilling picks up again after a reset
+    for (size_t i = 0; ok && i < 16; i++)
+    {
+        unsigned char *const data = rkArenaAlloc(arena, 4000);
+        ok = data != NULL;
+        if (ok)
+        {
+            data[0] = (unsigned char)i;
+        }
+    }
+    rkArenaGetStats(arena, &stats);
+    ok = ok && stats.spilledPageCount > 0;
+
+    // Growing a large block in place spills the pages it pushes over budget
+    rkResetArena(arena);
+    ok = ok && rkArenaSetSpill(arena, tempDirectory(), 16 * 4096);
+    unsigned char *const large = rkArenaAlloc(arena, 8192);
+    ok = ok && large && rkArenaAlloc(arena, 4000) && rkArenaAlloc(arena, 4000);
+    if (ok)
+    {
+        memset(large, 0x5A, 8192);
+    }
+
+    rkArenaGetStats(arena, &stats);
+    const size_t spilledBefore = stats.spilledPageCount;
+
+    unsigned char *const grown = ok ? rkArenaRealloc(arena, large, 8192, 32 * 4096) : NULL;
+    ok = ok && grown && grown[0] == 0x5A && grown[8191] == 0x5A;
+    rkArenaGetStats(arena, &stats);
+    ok = ok && stats.spilledPageCount > spilledBefore;
+
+    rkFreeArena(arena);
+    return ok;
+}
 
 int main(void)
 {
@@ -30,5 +1463,156 @@ int main(void)
     rkDebugArena(arena);
 
     rkFreeArena(arena);
+
+    if (!testPressureTrim())
+    {
+        fprintf(stderr, "Pressure trimming test failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!testNumaPolicy())
+    {
+        fprintf(stderr, "NUMA placement test failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!testPrefetch())
+    {
+        fprintf(stderr, "Prefetching test failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!testTailReuse())
+    {
+        fprintf(stderr, "Page tail reuse test failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!testHints())
+    {
+        fprintf(stderr, "Lifetime hint test failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!testArenaPool())
+    {
+        fprintf(stderr, "Arena pool test failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!testExecutor())
+    {
+        fprintf(stderr, "Executor test failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!testOwns())
+    {
+        fprintf(stderr, "Pointer ownership test failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!testPageRefcounts())
+    {
+        fprintf(stderr, "Page reference count test failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!testLargeRealloc())
+    {
+        fprintf(stderr, "Large block growth test failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!testReserveSlices())
+    {
+        fprintf(stderr, "Slice reservation test failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!testAbsorb())
+    {
+        fprintf(stderr, "Arena absorption test failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!testPoolRemoteFree())
+    {
+        fprintf(stderr, "Object pool remote free test failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!testBufferSlices())
+    {
+        fprintf(stderr, "Buffer slice test failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!testDirectRead())
+    {
+        fprintf(stderr, "Direct I/O read test failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!testMapFile())
+    {
+        fprintf(stderr, "File mapping test failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!testWritev())
+    {
+        fprintf(stderr, "Scatter-gather write test failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!testIngest())
+    {
+        fprintf(stderr, "Arena read test failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!testForkFlags())
+    {
+        fprintf(stderr, "Fork flag test failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!testFreeze())
+    {
+        fprintf(stderr, "Frozen arena test failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!testColdCompression())
+    {
+        fprintf(stderr, "Cold page compression test failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!testColdConcurrency())
+    {
+        fprintf(stderr, "Cold page concurrency test failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!testCompressLimit())
+    {
+        fprintf(stderr, "Compressed arena limit test failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!testSpill())
+    {
+        fprintf(stderr, "Spill test failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!testSpillConcurrency())
+    {
+        fprintf(stderr, "Spill concurrency test failed\n");
+        return EXIT_FAILURE;
+    }
+
     return EXIT_SUCCESS;
 }